@@ -62,6 +62,25 @@ struct packet_provider_data {
   GTree       *frames_user_comments; /* BST with user comments for frames (key = frame_data) */
 };
 
+/*
+ * Which of a few display filter fields each frame contains, as seen by a
+ * rescan; used to skip the frames a later display filter can't match
+ * without dissecting them again.
+ */
+#define FIELD_PRESENCE_MAX_FIELDS 16
+
+typedef struct {
+  int       hfids[FIELD_PRESENCE_MAX_FIELDS];   /* Fields being tracked */
+  int       num_valid;            /* Number of fields whose bits are valid for every frame */
+  int       num_fields;           /* Number of fields tracked by the current rescan */
+  gboolean  recording;            /* TRUE if the current rescan records field bits */
+  gboolean  complete;             /* TRUE if every frame so far in this rescan was recorded */
+  guint16  *bits;                 /* One bit per tracked field, per frame */
+  guint32   bits_len;             /* Number of frames "bits" has room for */
+  guint16   reject_masks[FIELD_PRESENCE_MAX_FIELDS]; /* Frames with none of the bits in one of these fail the display filter */
+  int       num_reject_masks;
+} field_presence_t;
+
 typedef struct _capture_file {
   epan_t                     *epan;
   file_state                  state;                /* Current state of capture file */
@@ -93,6 +112,7 @@ typedef struct _capture_file {
   gboolean                    redissecting;         /* TRUE if currently redissecting (cf_redissect_packets) */
   gboolean                    read_lock;            /* TRUE if currently processing a file (cf_read) */
   rescan_type                 redissection_queued;  /* Queued redissection type. */
+  field_presence_t            field_presence;       /* Display filter fields seen in each frame */
   /* search */
   gchar                      *sfilter;              /* Filter, hex value, or string being searched */
   gboolean                    hex;                  /* TRUE if "Hex value" search was last selected */
@@ -131,6 +151,7 @@ extern void cap_file_init(capture_file *cf);
 const char *cap_file_provider_get_interface_name(struct packet_provider_data *prov, guint32 interface_id);
 const char *cap_file_provider_get_interface_description(struct packet_provider_data *prov, guint32 interface_id);
 const char *cap_file_provider_get_user_comment(struct packet_provider_data *prov, const frame_data *fd);
+void cap_file_provider_get_shift_offset(struct packet_provider_data *prov, guint32 frame_num, nstime_t *offset);
 void cap_file_provider_set_user_comment(struct packet_provider_data *prov, frame_data *fd, const char *new_comment);
 
 #ifdef __cplusplus
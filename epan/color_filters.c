@@ -43,6 +43,12 @@ static GSList *color_filter_list = NULL;
 static GSList *color_filter_deleted_list = NULL;
 static GSList *color_filter_valid_list   = NULL;
 
+/* The enabled filters of color_filter_list, in order, and a multi-filter
+ * made of their compiled filters, so that the fields they test are read
+ * from the tree once per packet rather than once per filter. */
+static GPtrArray       *color_filter_multi_filters = NULL;
+static dfilter_multi_t *color_filter_multi = NULL;
+
 /* Color Filters can en-/disabled. */
 static gboolean filters_enabled = TRUE;
 
@@ -51,6 +57,61 @@ static gboolean filters_enabled = TRUE;
  */
 static gboolean tmp_colors_set = FALSE;
 
+/* Forget the multi-filter; it's rebuilt when it's next needed.  This must
+ * be done before any filter in it is freed. */
+static void
+color_filters_multi_invalidate(void)
+{
+    dfilter_multi_free(color_filter_multi);
+    color_filter_multi = NULL;
+    if (color_filter_multi_filters) {
+        g_ptr_array_free(color_filter_multi_filters, TRUE);
+        color_filter_multi_filters = NULL;
+    }
+}
+
+/* Check that the multi-filter still matches color_filter_list, in case
+ * a filter was enabled or disabled behind our back. */
+static gboolean
+color_filters_multi_valid(void)
+{
+    GSList         *curr;
+    color_filter_t *colorf;
+    guint           i = 0;
+
+    if (color_filter_multi == NULL)
+        return FALSE;
+
+    for (curr = color_filter_list; curr != NULL; curr = g_slist_next(curr)) {
+        colorf = (color_filter_t *)curr->data;
+        if (colorf->disabled || colorf->c_colorfilter == NULL)
+            continue;
+        if (i >= color_filter_multi_filters->len ||
+            g_ptr_array_index(color_filter_multi_filters, i) != colorf)
+            return FALSE;
+        i++;
+    }
+    return i == color_filter_multi_filters->len;
+}
+
+static void
+color_filters_multi_build(void)
+{
+    GSList         *curr;
+    color_filter_t *colorf;
+
+    color_filters_multi_invalidate();
+    color_filter_multi = dfilter_multi_new();
+    color_filter_multi_filters = g_ptr_array_new();
+    for (curr = color_filter_list; curr != NULL; curr = g_slist_next(curr)) {
+        colorf = (color_filter_t *)curr->data;
+        if (colorf->disabled || colorf->c_colorfilter == NULL)
+            continue;
+        dfilter_multi_add(color_filter_multi, colorf->c_colorfilter);
+        g_ptr_array_add(color_filter_multi_filters, colorf);
+    }
+}
+
 /* Create a new filter */
 color_filter_t *
 color_filter_new(const gchar *name,          /* The name of the filter to create */
@@ -158,6 +219,7 @@ color_filters_set_tmp(guint8 filt_nr, const gchar *filter, gboolean disabled, gc
                 g_free(local_err_msg);
                 return FALSE;
             } else {
+                color_filters_multi_invalidate();
                 g_free(colorf->filter_text);
                 dfilter_free(colorf->c_colorfilter);
                 colorf->filter_text = g_strdup(tmpfilter);
@@ -322,6 +384,7 @@ gboolean
 color_filters_init(gchar** err_msg, color_filter_add_cb_func add_cb)
 {
     /* delete all currently existing filters */
+    color_filters_multi_invalidate();
     color_filter_list_delete(&color_filter_list);
 
     /* now try to construct the filters list */
@@ -333,6 +396,7 @@ color_filters_reload(gchar** err_msg, color_filter_add_cb_func add_cb)
 {
     /* "move" old entries to the deleted list
      * we must keep them until the dissection no longer needs them */
+    color_filters_multi_invalidate();
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
 
@@ -344,6 +408,7 @@ void
 color_filters_cleanup(void)
 {
     /* delete the previously deleted filters */
+    color_filters_multi_invalidate();
     color_filter_list_delete(&color_filter_deleted_list);
 }
 
@@ -427,6 +492,7 @@ color_filters_apply(GSList *tmp_cfl, GSList *edit_cfl, gchar** err_msg)
 
     /* "move" old entries to the deleted list
      * we must keep them until the dissection no longer needs them */
+    color_filters_multi_invalidate();
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
 
@@ -490,22 +556,16 @@ color_filters_prime_edt(epan_dissect_t *edt)
 const color_filter_t *
 color_filters_colorize_packet(epan_dissect_t *edt)
 {
-    GSList         *curr;
-    color_filter_t *colorf;
+    int             i;
 
     /* If we have color filters, "search" for the matching one. */
     if ((edt->tree != NULL) && (color_filters_used())) {
-        curr = color_filter_list;
-
-        while(curr != NULL) {
-            colorf = (color_filter_t *)curr->data;
-            if ( (!colorf->disabled) &&
-                 (colorf->c_colorfilter != NULL) &&
-                 dfilter_apply_edt(colorf->c_colorfilter, edt)) {
-                return colorf;
-            }
-            curr = g_slist_next(curr);
-        }
+        if (!color_filters_multi_valid())
+            color_filters_multi_build();
+
+        i = dfilter_multi_apply_first(color_filter_multi, edt->tree);
+        if (i >= 0)
+            return (color_filter_t *)g_ptr_array_index(color_filter_multi_filters, i);
     }
 
     return NULL;
@@ -65,6 +65,17 @@ static wmem_map_t *conversation_hashtable_no_addr2_or_port2 = NULL;
 
 static guint32 new_index;
 
+/*
+ * Routines protocols registered to release their conversation data
+ * when a conversation is expired.
+ */
+typedef struct {
+	int proto;
+	conversation_expire_func func;
+} conversation_expire_routine_t;
+
+static GArray *conversation_expire_routines = NULL;
+
 /*
  * Placeholder for address-less conversations.
  */
@@ -742,6 +753,7 @@ conversation_new(const guint32 setup_frame, const address *addr1, const address
 
 	conversation->conv_index = new_index;
 	conversation->setup_frame = conversation->last_frame = setup_frame;
+	conversation->last_seen_frame = setup_frame;
 	conversation->data_list = NULL;
 
 	conversation->dissector_tree = wmem_tree_new(wmem_file_scope());
@@ -872,8 +884,12 @@ conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, co
 	if (chain_head && (chain_head->setup_frame <= frame_num)) {
 		match = chain_head;
 
-		if ((chain_head->last)&&(chain_head->last->setup_frame<=frame_num))
-			return chain_head->last;
+		if ((chain_head->last)&&(chain_head->last->setup_frame<=frame_num)) {
+			match = chain_head->last;
+			if (match->last_seen_frame < frame_num)
+				match->last_seen_frame = frame_num;
+			return match;
+		}
 
 		if ((chain_head->latest_found)&&(chain_head->latest_found->setup_frame<=frame_num))
 			match = chain_head->latest_found;
@@ -885,8 +901,11 @@ conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, co
 		}
 	}
 
-	if (match)
+	if (match) {
 		chain_head->latest_found = match;
+		if (match->last_seen_frame < frame_num)
+			match->last_seen_frame = frame_num;
+	}
 
 	return match;
 }
@@ -1324,6 +1343,170 @@ conversation_delete_proto_data(conversation_t *conv, const int proto)
 		wmem_tree_remove32(conv->data_list, proto);
 }
 
+void
+conversation_register_expire_routine(const int proto, conversation_expire_func func)
+{
+	conversation_expire_routine_t routine;
+
+	if (conversation_expire_routines == NULL)
+		conversation_expire_routines = g_array_new(FALSE, FALSE, sizeof(conversation_expire_routine_t));
+
+	routine.proto = proto;
+	routine.func = func;
+	g_array_append_val(conversation_expire_routines, routine);
+}
+
+typedef struct {
+	guint32 last_seen_before;
+	wmem_map_t *hashtable;
+	GPtrArray *expired;	/* (hash table, conversation) pairs */
+} conversation_expire_data_t;
+
+static conversation_expire_func
+conversation_find_expire_routine(const int proto)
+{
+	guint i;
+
+	if (conversation_expire_routines == NULL)
+		return NULL;
+
+	for (i = 0; i < conversation_expire_routines->len; i++) {
+		conversation_expire_routine_t *routine =
+		    &g_array_index(conversation_expire_routines, conversation_expire_routine_t, i);
+
+		if (routine->proto == proto)
+			return routine->func;
+	}
+
+	return NULL;
+}
+
+static gboolean
+conversation_proto_data_not_expirable(const void *key, void *value _U_, void *userdata _U_)
+{
+	/* Returning TRUE stops the traversal. */
+	return conversation_find_expire_routine(GPOINTER_TO_INT(key)) == NULL;
+}
+
+/*
+ * A conversation can only be freed if every protocol that attached data to
+ * it knows how to release that data.  A conversation without any data is
+ * kept too: whoever looked it up may well have kept a pointer to it.
+ */
+static gboolean
+conversation_is_expirable(conversation_t *conv)
+{
+	if (conv->data_list == NULL || wmem_tree_is_empty(conv->data_list))
+		return FALSE;
+
+	return !wmem_tree_foreach(conv->data_list, conversation_proto_data_not_expirable, NULL);
+}
+
+static void
+conversation_collect_expired(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	conversation_expire_data_t *data = (conversation_expire_data_t *)user_data;
+	conversation_t *conv;
+
+	for (conv = (conversation_t *)value; conv; conv = conv->next) {
+		if (conv->last_seen_frame < data->last_seen_before &&
+		    conversation_is_expirable(conv)) {
+			g_ptr_array_add(data->expired, data->hashtable);
+			g_ptr_array_add(data->expired, conv);
+		}
+	}
+}
+
+/*
+ * Take a conversation off its hash chain.  Whatever remains of the chain
+ * is re-keyed with its head's own key, as the key the map holds may be
+ * that of the conversation being freed.
+ */
+static void
+conversation_unlink(wmem_map_t *hashtable, conversation_t *conv)
+{
+	conversation_t *chain_head, *new_head;
+
+	chain_head = (conversation_t *)wmem_map_lookup(hashtable, conv->key_ptr);
+	if (chain_head == NULL)
+		return;
+
+	if (conv == chain_head) {
+		new_head = conv->next;
+		if (new_head) {
+			new_head->last = conv->last;
+			if (conv->latest_found == conv)
+				new_head->latest_found = NULL;
+			else
+				new_head->latest_found = conv->latest_found;
+		}
+	} else {
+		conversation_remove_from_hashtable(hashtable, conv);
+		new_head = chain_head;
+	}
+
+	wmem_map_remove(hashtable, conv->key_ptr);
+	if (new_head)
+		wmem_map_insert(hashtable, new_head->key_ptr, new_head);
+}
+
+static gboolean
+conversation_expire_proto_data(const void *key, void *value, void *userdata)
+{
+	conversation_t *conv = (conversation_t *)userdata;
+	conversation_expire_func func = conversation_find_expire_routine(GPOINTER_TO_INT(key));
+
+	/* conversation_is_expirable() made sure there is one */
+	func(conv, value);
+	return FALSE;
+}
+
+static void
+conversation_free(conversation_t *conv)
+{
+	wmem_tree_foreach(conv->data_list, conversation_expire_proto_data, conv);
+	wmem_tree_destroy(conv->data_list, FALSE, FALSE);
+	wmem_tree_destroy(conv->dissector_tree, FALSE, FALSE);
+
+	free_address_wmem(wmem_file_scope(), &conv->key_ptr->addr1);
+	free_address_wmem(wmem_file_scope(), &conv->key_ptr->addr2);
+	wmem_free(wmem_file_scope(), conv->key_ptr);
+	wmem_free(wmem_file_scope(), conv);
+}
+
+guint
+conversation_expire(const guint32 last_seen_before)
+{
+	conversation_expire_data_t data;
+	guint i, count;
+
+	data.last_seen_before = last_seen_before;
+	data.expired = g_ptr_array_new();
+
+	data.hashtable = conversation_hashtable_exact;
+	wmem_map_foreach(data.hashtable, conversation_collect_expired, &data);
+	data.hashtable = conversation_hashtable_no_addr2;
+	wmem_map_foreach(data.hashtable, conversation_collect_expired, &data);
+	data.hashtable = conversation_hashtable_no_port2;
+	wmem_map_foreach(data.hashtable, conversation_collect_expired, &data);
+	data.hashtable = conversation_hashtable_no_addr2_or_port2;
+	wmem_map_foreach(data.hashtable, conversation_collect_expired, &data);
+
+	count = data.expired->len / 2;
+	DPRINT(("expiring %u conversations last seen before frame #%u", count, last_seen_before));
+
+	for (i = 0; i < data.expired->len; i += 2) {
+		wmem_map_t *hashtable = (wmem_map_t *)g_ptr_array_index(data.expired, i);
+		conversation_t *conv = (conversation_t *)g_ptr_array_index(data.expired, i + 1);
+
+		conversation_unlink(hashtable, conv);
+		conversation_free(conv);
+	}
+
+	g_ptr_array_free(data.expired, TRUE);
+	return count;
+}
+
 void
 conversation_set_dissector_from_frame_number(conversation_t *conversation,
 	const guint32 starting_frame_num, const dissector_handle_t handle)
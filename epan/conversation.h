@@ -95,6 +95,7 @@ typedef struct conversation {
 	guint32 setup_frame;		/** frame number that setup this conversation */
 	/* Assume that setup_frame is also the lowest frame number for now. */
 	guint32 last_frame;		/** highest frame number in this conversation */
+	guint32 last_seen_frame;	/** highest frame number in which this conversation was looked up */
 	wmem_tree_t *data_list;			/** list of data associated with conversation */
 	wmem_tree_t *dissector_tree;
 								/** tree containing protocol dissector client associated with conversation */
@@ -199,6 +200,32 @@ WS_DLL_PUBLIC void conversation_add_proto_data(conversation_t *conv, const int p
 WS_DLL_PUBLIC void *conversation_get_proto_data(const conversation_t *conv, const int proto);
 WS_DLL_PUBLIC void conversation_delete_proto_data(conversation_t *conv, const int proto);
 
+/** Routine called for a protocol's data when the conversation holding it
+ *  is expired; it should free the data and whatever it points to.
+ */
+typedef void (*conversation_expire_func)(conversation_t *conv, void *proto_data);
+
+/** Register a routine to be called with the data a protocol attached to a
+ *  conversation with conversation_add_proto_data() when that conversation
+ *  is expired by conversation_expire().
+ */
+WS_DLL_PUBLIC void conversation_register_expire_routine(const int proto,
+    conversation_expire_func func);
+
+/** Free every conversation that was last looked up before the given frame
+ *  number, calling the registered expire routines for its protocol data.
+ *  Only conversations that hold data, all of it from protocols that have
+ *  registered an expire routine, are freed.
+ *
+ *  This is only safe for a single in-order pass over the packets, where no
+ *  earlier frame is dissected again.  Dissectors that need to refer to a
+ *  conversation from their own tables must use its conv_index rather than
+ *  a pointer to it.
+ *
+ *  @return the number of conversations freed
+ */
+WS_DLL_PUBLIC guint conversation_expire(const guint32 last_seen_before);
+
 WS_DLL_PUBLIC void conversation_set_dissector(conversation_t *conversation,
     const dissector_handle_t handle);
 
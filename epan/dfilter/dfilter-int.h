@@ -15,6 +15,16 @@
 #include <epan/proto.h>
 #include <stdio.h>
 
+/* A field tested by the filters of a dfilter_multi_t; whether it is in
+ * the tree, and its values, are looked up at most once per packet. */
+typedef struct {
+	header_field_info	*hfinfo;
+	guint		gen;		/* packet the state below is for */
+	gboolean	present;
+	gboolean	loaded;		/* values has been built */
+	GList		*values;
+} dfilter_field_slot_t;
+
 /* Passed back to user */
 struct epan_dfilter {
 	GPtrArray	*insns;
@@ -26,7 +36,15 @@ struct epan_dfilter {
 	gboolean	*owns_memory;
 	int		*interesting_fields;
 	int		num_interesting_fields;
+	int		*required_fields;
+	int		num_required_fields;
 	GPtrArray	*deprecated;
+
+	/* Set by dfilter_multi_apply_nth() while the filter runs. */
+	dfilter_field_slot_t	*field_slots;
+	guint		field_gen;
+	const int	*insn_slots;	/* slot per instruction, or -1 */
+	const gboolean	*shared_regs;	/* registers holding slot values */
 };
 
 typedef struct {
@@ -132,6 +132,7 @@ dfilter_free(dfilter_t *df)
 	}
 
 	g_free(df->interesting_fields);
+	g_free(df->required_fields);
 
 	/* Clear registers with constant values (as set by dfvm_init_const).
 	 * Other registers were cleared on RETURN by free_register_overhead. */
@@ -335,10 +336,12 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 		}
 
 		/* Create bytecode */
+		dfilter = dfilter_new();
+		dfilter->required_fields = dfw_required_fields(dfw,
+			&dfilter->num_required_fields);
 		dfw_gencode(dfw);
 
 		/* Tuck away the bytecode in the dfilter_t */
-		dfilter = dfilter_new();
 		dfilter->insns = dfw->insns;
 		dfilter->consts = dfw->consts;
 		dfw->insns = NULL;
@@ -427,6 +430,13 @@ dfilter_has_interesting_fields(const dfilter_t *df)
 	return (df->num_interesting_fields > 0);
 }
 
+int
+dfilter_required_fields(const dfilter_t *df, const int **fields)
+{
+	*fields = df->required_fields;
+	return df->num_required_fields;
+}
+
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df) {
 	if (df->deprecated && df->deprecated->len > 0) {
@@ -453,6 +463,187 @@ dfilter_dump(dfilter_t *df)
 	}
 }
 
+typedef struct {
+	dfilter_t	*df;
+	int		*insn_slots;
+	gboolean	*shared_regs;
+	int		*required_slots;
+	int		num_required_slots;
+} dfilter_multi_entry_t;
+
+struct epan_dfilter_multi {
+	GArray		*entries;	/* dfilter_multi_entry_t, in order */
+	GArray		*slots;		/* dfilter_field_slot_t */
+	GHashTable	*slot_ids;	/* field id -> slot + 1 */
+	guint		gen;		/* current packet */
+};
+
+dfilter_multi_t *
+dfilter_multi_new(void)
+{
+	dfilter_multi_t *dfm = g_new(dfilter_multi_t, 1);
+
+	dfm->entries = g_array_new(FALSE, FALSE, sizeof(dfilter_multi_entry_t));
+	dfm->slots = g_array_new(FALSE, TRUE, sizeof(dfilter_field_slot_t));
+	dfm->slot_ids = g_hash_table_new(g_direct_hash, g_direct_equal);
+	dfm->gen = 1;
+	return dfm;
+}
+
+/* Return the slot for a field, adding one if no filter has used it yet. */
+static int
+dfilter_multi_slot(dfilter_multi_t *dfm, header_field_info *hfinfo)
+{
+	dfilter_field_slot_t	new_slot;
+	int			slot;
+
+	slot = GPOINTER_TO_INT(g_hash_table_lookup(dfm->slot_ids,
+				GINT_TO_POINTER(hfinfo->id)));
+	if (slot == 0) {
+		memset(&new_slot, 0, sizeof(new_slot));
+		new_slot.hfinfo = hfinfo;
+		g_array_append_val(dfm->slots, new_slot);
+		slot = dfm->slots->len;
+		g_hash_table_insert(dfm->slot_ids, GINT_TO_POINTER(hfinfo->id),
+				GINT_TO_POINTER(slot));
+	}
+	return slot - 1;
+}
+
+guint
+dfilter_multi_add(dfilter_multi_t *dfm, dfilter_t *df)
+{
+	dfilter_multi_entry_t	entry;
+	dfvm_insn_t		*insn;
+	guint			i;
+
+	memset(&entry, 0, sizeof(entry));
+	entry.df = df;
+
+	if (df) {
+		entry.insn_slots = g_new(int, df->insns->len);
+		entry.shared_regs = g_new0(gboolean, df->max_registers);
+		for (i = 0; i < df->insns->len; i++) {
+			insn = (dfvm_insn_t *)g_ptr_array_index(df->insns, i);
+			switch (insn->op) {
+				case READ_TREE:
+					entry.shared_regs[insn->arg2->value.numeric] = TRUE;
+					/* FALL THROUGH */
+				case CHECK_EXISTS:
+				case FIELD_UINT_CMP:
+					entry.insn_slots[i] = dfilter_multi_slot(dfm,
+							insn->arg1->value.hfinfo);
+					break;
+				default:
+					entry.insn_slots[i] = -1;
+					break;
+			}
+		}
+
+		/* A packet without one of these can't match; checking for
+		 * them first saves running the filter at all. */
+		entry.num_required_slots = df->num_required_fields;
+		entry.required_slots = g_new(int, df->num_required_fields);
+		for (i = 0; i < (guint)df->num_required_fields; i++) {
+			entry.required_slots[i] = dfilter_multi_slot(dfm,
+					proto_registrar_get_nth(df->required_fields[i]));
+		}
+	}
+
+	g_array_append_val(dfm->entries, entry);
+	return dfm->entries->len - 1;
+}
+
+void
+dfilter_multi_reset(dfilter_multi_t *dfm)
+{
+	guint i;
+
+	dfm->gen++;
+	if (dfm->gen == 0) {
+		/* Wrapped; make sure no slot looks current. */
+		for (i = 0; i < dfm->slots->len; i++) {
+			g_array_index(dfm->slots, dfilter_field_slot_t, i).gen = 0;
+		}
+		dfm->gen = 1;
+	}
+}
+
+gboolean
+dfilter_multi_apply_nth(dfilter_multi_t *dfm, guint idx, proto_tree *tree)
+{
+	dfilter_multi_entry_t	*entry;
+	dfilter_field_slot_t	*slots;
+	dfilter_t		*df;
+	gboolean		matched;
+	int			i;
+
+	g_assert(idx < dfm->entries->len);
+	entry = &g_array_index(dfm->entries, dfilter_multi_entry_t, idx);
+	df = entry->df;
+	if (df == NULL) {
+		return TRUE;
+	}
+
+	slots = (dfilter_field_slot_t *)(void *)dfm->slots->data;
+	for (i = 0; i < entry->num_required_slots; i++) {
+		if (!dfvm_field_slot_present(&slots[entry->required_slots[i]],
+					dfm->gen, tree)) {
+			return FALSE;
+		}
+	}
+
+	df->field_slots = slots;
+	df->field_gen = dfm->gen;
+	df->insn_slots = entry->insn_slots;
+	df->shared_regs = entry->shared_regs;
+	matched = dfvm_apply(df, tree);
+	df->field_slots = NULL;
+	df->insn_slots = NULL;
+	df->shared_regs = NULL;
+	return matched;
+}
+
+int
+dfilter_multi_apply_first(dfilter_multi_t *dfm, proto_tree *tree)
+{
+	guint i;
+
+	dfilter_multi_reset(dfm);
+	for (i = 0; i < dfm->entries->len; i++) {
+		if (dfilter_multi_apply_nth(dfm, i, tree)) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+void
+dfilter_multi_free(dfilter_multi_t *dfm)
+{
+	dfilter_multi_entry_t	*entry;
+	dfilter_field_slot_t	*slot;
+	guint			i;
+
+	if (!dfm)
+		return;
+
+	for (i = 0; i < dfm->entries->len; i++) {
+		entry = &g_array_index(dfm->entries, dfilter_multi_entry_t, i);
+		g_free(entry->insn_slots);
+		g_free(entry->shared_regs);
+		g_free(entry->required_slots);
+	}
+	for (i = 0; i < dfm->slots->len; i++) {
+		slot = &g_array_index(dfm->slots, dfilter_field_slot_t, i);
+		g_list_free(slot->values);
+	}
+	g_array_free(dfm->entries, TRUE);
+	g_array_free(dfm->slots, TRUE);
+	g_hash_table_destroy(dfm->slot_ids);
+	g_free(dfm);
+}
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *
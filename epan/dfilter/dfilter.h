@@ -72,10 +72,55 @@ dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
 gboolean
 dfilter_has_interesting_fields(const dfilter_t *df);
 
+/* Get the fields a packet must have for the dfilter to match it: for each
+ * field id returned, the dfilter can't match a packet that contains neither
+ * that field nor another field with the same name.  The ids are those of
+ * the first field registered with each name.  Returns the number of fields;
+ * the array belongs to the dfilter. */
+WS_DLL_PUBLIC
+int
+dfilter_required_fields(const dfilter_t *df, const int **fields);
+
 WS_DLL_PUBLIC
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df);
 
+/* A list of dfilters that are applied to the same packets.  The fields
+ * they test are looked up in the tree, and their values collected, at
+ * most once per packet, however many of the dfilters test them.  The
+ * dfilters still belong to the caller, and must outlive the list. */
+typedef struct epan_dfilter_multi dfilter_multi_t;
+
+WS_DLL_PUBLIC
+dfilter_multi_t *
+dfilter_multi_new(void);
+
+/* Add a dfilter at the end of the list, and return its index.  A NULL
+ * dfilter matches every packet. */
+WS_DLL_PUBLIC
+guint
+dfilter_multi_add(dfilter_multi_t *dfm, dfilter_t *df);
+
+/* Start a new packet: forget what was looked up in the previous tree. */
+WS_DLL_PUBLIC
+void
+dfilter_multi_reset(dfilter_multi_t *dfm);
+
+/* Apply the dfilter at index idx to the tree of the current packet. */
+WS_DLL_PUBLIC
+gboolean
+dfilter_multi_apply_nth(dfilter_multi_t *dfm, guint idx, proto_tree *tree);
+
+/* Start a new packet and return the index of the first dfilter in the
+ * list that matches it, or -1 if none does. */
+WS_DLL_PUBLIC
+int
+dfilter_multi_apply_first(dfilter_multi_t *dfm, proto_tree *tree);
+
+WS_DLL_PUBLIC
+void
+dfilter_multi_free(dfilter_multi_t *dfm);
+
 /* Print bytecode of dfilter to stdout */
 WS_DLL_PUBLIC
 void
@@ -72,6 +72,37 @@ dfvm_value_new(dfvm_value_type_t type)
 	return v;
 }
 
+gboolean
+dfvm_uinteger_ftype(ftenum_t ftype)
+{
+	switch (ftype) {
+		case FT_CHAR:
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+		case FT_FRAMENUM:
+			return TRUE;
+		default:
+			return FALSE;
+	}
+}
+
+static const char *
+uint_cmp_op_str(dfvm_opcode_t op)
+{
+	switch (op) {
+		case ANY_EQ:	return "==";
+		case ANY_NE:	return "!=";
+		case ANY_GT:	return ">";
+		case ANY_GE:	return ">=";
+		case ANY_LT:	return "<";
+		case ANY_LE:	return "<=";
+		default:
+			g_assert_not_reached();
+			return "?";
+	}
+}
 
 void
 dfvm_dump(FILE *f, dfilter_t *df)
@@ -119,6 +150,7 @@ dfvm_dump(FILE *f, dfilter_t *df)
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
 			case ANY_IN_RANGE:
+			case FIELD_UINT_CMP:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
@@ -259,6 +291,13 @@ dfvm_dump(FILE *f, dfilter_t *df)
 					arg3->value.numeric);
 				break;
 
+			case FIELD_UINT_CMP:
+				fprintf(f, "%05d FIELD_UINT_CMP\t%s %s reg#%u\n",
+					id, arg1->value.hfinfo->abbrev,
+					uint_cmp_op_str((dfvm_opcode_t)arg3->value.numeric),
+					arg2->value.numeric);
+				break;
+
 			case NOT:
 				fprintf(f, "%05d NOT\n", id);
 				break;
@@ -337,6 +376,71 @@ read_tree(dfilter_t *df, proto_tree *tree, header_field_info *hfinfo, int reg)
 }
 
 
+gboolean
+dfvm_field_slot_present(dfilter_field_slot_t *slot, guint gen, proto_tree *tree)
+{
+	header_field_info	*hfinfo;
+	GPtrArray		*finfos;
+
+	if (slot->gen != gen) {
+		slot->gen = gen;
+		slot->present = FALSE;
+		if (slot->loaded) {
+			g_list_free(slot->values);
+			slot->values = NULL;
+			slot->loaded = FALSE;
+		}
+		for (hfinfo = slot->hfinfo; hfinfo; hfinfo = hfinfo->same_name_next) {
+			finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+			if (finfos != NULL && g_ptr_array_len(finfos) > 0) {
+				slot->present = TRUE;
+				break;
+			}
+		}
+	}
+	return slot->present;
+}
+
+/* Like read_tree(), but the list of fvalues is built once per packet in
+ * a slot shared with the other filters of a dfilter_multi_t. */
+static gboolean
+read_tree_shared(dfilter_t *df, proto_tree *tree, dfilter_field_slot_t *slot, int reg)
+{
+	header_field_info	*hfinfo;
+	GPtrArray		*finfos;
+	guint			i;
+
+	if (df->attempted_load[reg]) {
+		return df->registers[reg] != NULL;
+	}
+
+	df->attempted_load[reg] = TRUE;
+
+	if (!dfvm_field_slot_present(slot, df->field_gen, tree)) {
+		return FALSE;
+	}
+
+	if (!slot->loaded) {
+		for (hfinfo = slot->hfinfo; hfinfo; hfinfo = hfinfo->same_name_next) {
+			finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+			if (finfos == NULL) {
+				continue;
+			}
+			for (i = 0; i < finfos->len; i++) {
+				slot->values = g_list_prepend(slot->values,
+				    &((field_info *)g_ptr_array_index(finfos, i))->value);
+			}
+		}
+		slot->loaded = TRUE;
+	}
+
+	/* The slot owns the list; see free_register_overhead(). */
+	df->registers[reg] = slot->values;
+	df->owns_memory[reg] = FALSE;
+	return TRUE;
+}
+
+
 /* Put a constant value in a register. These will not be cleared by
  * free_register_overhead. */
 static gboolean
@@ -400,6 +504,64 @@ any_in_range(dfilter_t *df, int reg1, int reg2, int reg3)
 	return FALSE;
 }
 
+/* Compares the values of an unsigned integer field (see
+ * dfvm_uinteger_ftype()) straight from the tree against the constant in
+ * a register.  This is what READ_TREE followed by ANY_EQ etc. does, minus
+ * building the register list and calling through the ftype. */
+static gboolean
+field_uint_cmp(dfilter_t *df, proto_tree *tree, header_field_info *hfinfo,
+		int reg, dfvm_opcode_t op)
+{
+	GPtrArray	*finfos;
+	field_info	*finfo;
+	guint32		a, b;
+	guint		i;
+
+	b = ((fvalue_t *)df->registers[reg]->data)->value.uinteger;
+
+	for (; hfinfo; hfinfo = hfinfo->same_name_next) {
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		if (finfos == NULL) {
+			continue;
+		}
+
+		for (i = 0; i < finfos->len; i++) {
+			finfo = (field_info *)g_ptr_array_index(finfos, i);
+			a = finfo->value.value.uinteger;
+			switch (op) {
+				case ANY_EQ:
+					if (a == b)
+						return TRUE;
+					break;
+				case ANY_NE:
+					if (a != b)
+						return TRUE;
+					break;
+				case ANY_GT:
+					if (a > b)
+						return TRUE;
+					break;
+				case ANY_GE:
+					if (a >= b)
+						return TRUE;
+					break;
+				case ANY_LT:
+					if (a < b)
+						return TRUE;
+					break;
+				case ANY_LE:
+					if (a <= b)
+						return TRUE;
+					break;
+				default:
+					g_assert_not_reached();
+					break;
+			}
+		}
+	}
+	return FALSE;
+}
+
 
 static void
 free_owned_register(gpointer data, gpointer user_data _U_)
@@ -418,6 +580,10 @@ free_register_overhead(dfilter_t* df)
 	for (i = 0; i < df->num_registers; i++) {
 		df->attempted_load[i] = FALSE;
 		if (df->registers[i]) {
+			if (df->shared_regs && df->shared_regs[i]) {
+				df->registers[i] = NULL;
+				continue;
+			}
 			if (df->owns_memory[i]) {
 				g_list_foreach(df->registers[i], free_owned_register, NULL);
 				df->owns_memory[i] = FALSE;
@@ -471,6 +637,7 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 	header_field_info	*hfinfo;
 	GList		*param1;
 	GList		*param2;
+	int		slot;
 
 	g_assert(tree);
 
@@ -485,6 +652,11 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 		switch (insn->op) {
 			case CHECK_EXISTS:
+				if (df->insn_slots && (slot = df->insn_slots[id]) >= 0) {
+					accum = dfvm_field_slot_present(&df->field_slots[slot],
+							df->field_gen, tree);
+					break;
+				}
 				hfinfo = arg1->value.hfinfo;
 				while(hfinfo) {
 					accum = proto_check_for_protocol_or_field(tree,
@@ -499,6 +671,11 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				break;
 
 			case READ_TREE:
+				if (df->insn_slots && (slot = df->insn_slots[id]) >= 0) {
+					accum = read_tree_shared(df, tree,
+							&df->field_slots[slot], arg2->value.numeric);
+					break;
+				}
 				accum = read_tree(df, tree,
 						arg1->value.hfinfo, arg2->value.numeric);
 				break;
@@ -579,6 +756,19 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 						arg3->value.numeric);
 				break;
 
+			case FIELD_UINT_CMP:
+				if (df->insn_slots && (slot = df->insn_slots[id]) >= 0 &&
+				    !dfvm_field_slot_present(&df->field_slots[slot],
+						df->field_gen, tree)) {
+					accum = FALSE;
+					break;
+				}
+				arg3 = insn->arg3;
+				accum = field_uint_cmp(df, tree,
+						arg1->value.hfinfo, arg2->value.numeric,
+						(dfvm_opcode_t)arg3->value.numeric);
+				break;
+
 			case NOT:
 				accum = !accum;
 				break;
@@ -654,6 +844,7 @@ dfvm_init_const(dfilter_t *df)
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
 			case ANY_IN_RANGE:
+			case FIELD_UINT_CMP:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
@@ -60,7 +60,8 @@ typedef enum {
 	ANY_MATCHES,
 	MK_RANGE,
 	CALL_FUNCTION,
-	ANY_IN_RANGE
+	ANY_IN_RANGE,
+	FIELD_UINT_CMP
 
 } dfvm_opcode_t;
 
@@ -91,4 +92,14 @@ dfvm_apply(dfilter_t *df, proto_tree *tree);
 void
 dfvm_init_const(dfilter_t *df);
 
+/* TRUE if values of this type are held and compared as a plain guint32,
+ * so that FIELD_UINT_CMP can test them without the fvalue functions. */
+gboolean
+dfvm_uinteger_ftype(ftenum_t ftype);
+
+/* TRUE if the field of a dfilter_multi_t slot is in the tree; the tree
+ * is only looked at the first time this is asked for a packet. */
+gboolean
+dfvm_field_slot_present(dfilter_field_slot_t *slot, guint gen, proto_tree *tree);
+
 #endif
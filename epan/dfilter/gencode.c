@@ -252,12 +252,85 @@ gen_relation_regs(dfwork_t *dfw, dfvm_opcode_t op, int reg1, int reg2)
 	dfw_append_insn(dfw, insn);
 }
 
+/**
+ * Adds a FIELD_UINT_CMP instruction if the relation compares an unsigned
+ * integer field against a constant, in which case the field values can
+ * be tested directly without loading them into a register first.
+ * Returns FALSE, without generating any code, otherwise.
+ */
+static gboolean
+gen_relation_uint(dfwork_t *dfw, dfvm_opcode_t op, stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	header_field_info	*hfinfo, *hf;
+	dfvm_insn_t		*insn;
+	dfvm_value_t		*val1, *val2, *val3;
+
+	switch (op) {
+		case ANY_EQ:
+		case ANY_NE:
+		case ANY_GT:
+		case ANY_GE:
+		case ANY_LT:
+		case ANY_LE:
+			break;
+		default:
+			return FALSE;
+	}
+
+	if (stnode_type_id(st_arg1) != STTYPE_FIELD ||
+	    stnode_type_id(st_arg2) != STTYPE_FVALUE) {
+		return FALSE;
+	}
+
+	if (!dfvm_uinteger_ftype(fvalue_type_ftenum((fvalue_t *)stnode_data(st_arg2)))) {
+		return FALSE;
+	}
+
+	/* Rewind to find the first field of this name; every field with
+	 * that name must be an unsigned integer as well. */
+	hfinfo = (header_field_info*)stnode_data(st_arg1);
+	while (hfinfo->same_name_prev_id != -1) {
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+	}
+	for (hf = hfinfo; hf != NULL; hf = hf->same_name_next) {
+		if (!dfvm_uinteger_ftype(hf->type)) {
+			return FALSE;
+		}
+	}
+
+	insn = dfvm_insn_new(FIELD_UINT_CMP);
+	val1 = dfvm_value_new(HFINFO);
+	val1->value.hfinfo = hfinfo;
+	val2 = dfvm_value_new(REGISTER);
+	val2->value.numeric = dfw_append_put_fvalue(dfw,
+			(fvalue_t *)stnode_steal_data(st_arg2));
+	val3 = dfvm_value_new(INTEGER);
+	val3->value.numeric = op;
+	insn->arg1 = val1;
+	insn->arg2 = val2;
+	insn->arg3 = val3;
+	dfw_append_insn(dfw, insn);
+
+	/* Record the FIELD_ID in hash of interesting fields. */
+	for (hf = hfinfo; hf != NULL; hf = hf->same_name_next) {
+		g_hash_table_insert(dfw->interesting_fields,
+			GINT_TO_POINTER(hf->id),
+			GUINT_TO_POINTER(TRUE));
+	}
+
+	return TRUE;
+}
+
 static void
 gen_relation(dfwork_t *dfw, dfvm_opcode_t op, stnode_t *st_arg1, stnode_t *st_arg2)
 {
 	dfvm_value_t	*jmp1 = NULL, *jmp2 = NULL;
 	int		reg1 = -1, reg2 = -1;
 
+	if (gen_relation_uint(dfw, op, st_arg1, st_arg2)) {
+		return;
+	}
+
 	/* Create code for the LHS and RHS of the relation */
 	reg1 = gen_entity(dfw, st_arg1, &jmp1);
 	reg2 = gen_entity(dfw, st_arg2, &jmp2);
@@ -661,6 +734,120 @@ dfw_interesting_fields(dfwork_t *dfw, int *caller_num_fields)
 	return hki.fields;
 }
 
+/* Adds the field in st_arg, if it is one, to the set of required fields. */
+static void
+add_required_field(stnode_t *st_arg, GHashTable *fields)
+{
+	header_field_info	*hfinfo;
+
+	if (stnode_type_id(st_arg) != STTYPE_FIELD) {
+		return;
+	}
+
+	/* Rewind to find the first field of this name. */
+	hfinfo = (header_field_info*)stnode_data(st_arg);
+	while (hfinfo->same_name_prev_id != -1) {
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+	}
+	g_hash_table_add(fields, GINT_TO_POINTER(hfinfo->id));
+}
+
+/* Adds to the set the fields without which the test in st_node can't be
+ * TRUE.  A relation whose field operand isn't present is FALSE (the load
+ * of the field jumps past the comparison), and so is an existence test. */
+static void
+gen_required_fields(stnode_t *st_node, GHashTable *fields)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+	GHashTable	*fields1, *fields2;
+	GHashTableIter	iter;
+	gpointer	key;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST) {
+		return;
+	}
+
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+
+	switch (st_op) {
+		case TEST_OP_EXISTS:
+			add_required_field(st_arg1, fields);
+			break;
+
+		case TEST_OP_AND:
+			gen_required_fields(st_arg1, fields);
+			gen_required_fields(st_arg2, fields);
+			break;
+
+		case TEST_OP_OR:
+			/* Only what both sides require. */
+			fields1 = g_hash_table_new(g_direct_hash, g_direct_equal);
+			fields2 = g_hash_table_new(g_direct_hash, g_direct_equal);
+			gen_required_fields(st_arg1, fields1);
+			gen_required_fields(st_arg2, fields2);
+			g_hash_table_iter_init(&iter, fields1);
+			while (g_hash_table_iter_next(&iter, &key, NULL)) {
+				if (g_hash_table_contains(fields2, key)) {
+					g_hash_table_add(fields, key);
+				}
+			}
+			g_hash_table_destroy(fields1);
+			g_hash_table_destroy(fields2);
+			break;
+
+		case TEST_OP_EQ:
+		case TEST_OP_NE:
+		case TEST_OP_GT:
+		case TEST_OP_GE:
+		case TEST_OP_LT:
+		case TEST_OP_LE:
+		case TEST_OP_BITWISE_AND:
+		case TEST_OP_CONTAINS:
+		case TEST_OP_MATCHES:
+			add_required_field(st_arg1, fields);
+			add_required_field(st_arg2, fields);
+			break;
+
+		case TEST_OP_IN:
+			/* Missing fields in the set are just skipped. */
+			add_required_field(st_arg1, fields);
+			break;
+
+		case TEST_OP_NOT:
+		case TEST_OP_UNINITIALIZED:
+			break;
+	}
+}
+
+/* Must be called before dfw_gencode(), which consumes parts of the
+ * syntax tree. */
+int*
+dfw_required_fields(dfwork_t *dfw, int *caller_num_fields)
+{
+	GHashTable	*fields;
+	int		num_fields;
+	hash_key_iterator hki;
+
+	fields = g_hash_table_new(g_direct_hash, g_direct_equal);
+	gen_required_fields(dfw->st_root, fields);
+
+	num_fields = g_hash_table_size(fields);
+	if (num_fields == 0) {
+		g_hash_table_destroy(fields);
+		*caller_num_fields = 0;
+		return NULL;
+	}
+
+	hki.fields = g_new(int, num_fields);
+	hki.i = 0;
+
+	g_hash_table_foreach(fields, get_hash_key, &hki);
+	g_hash_table_destroy(fields);
+	*caller_num_fields = num_fields;
+	return hki.fields;
+}
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *
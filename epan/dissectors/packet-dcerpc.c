@@ -691,7 +691,7 @@ static GSList *decode_dcerpc_bindings = NULL;
 static wmem_map_t *dcerpc_binds = NULL;
 
 typedef struct _dcerpc_bind_key {
-    conversation_t *conv;
+    guint32         conv_index;
     guint16         ctx_id;
     guint64         transport_salt;
 } dcerpc_bind_key;
@@ -771,7 +771,7 @@ dcerpc_add_conv_to_bind_table(decode_dcerpc_bind_values_t *binding)
     bind_value->transport = uuid_data_repr_proto;
 
     key = (dcerpc_bind_key *)wmem_alloc(wmem_file_scope(), sizeof (dcerpc_bind_key));
-    key->conv = conv;
+    key->conv_index = conv->conv_index;
     key->ctx_id = binding->ctx_id;
     key->transport_salt = binding->transport_salt;
 
@@ -1768,7 +1768,7 @@ dcerpc_bind_equal(gconstpointer k1, gconstpointer k2)
 {
     const dcerpc_bind_key *key1 = (const dcerpc_bind_key *)k1;
     const dcerpc_bind_key *key2 = (const dcerpc_bind_key *)k2;
-    return ((key1->conv == key2->conv)
+    return ((key1->conv_index == key2->conv_index)
             && (key1->ctx_id == key2->ctx_id)
             && (key1->transport_salt == key2->transport_salt));
 }
@@ -1779,7 +1779,7 @@ dcerpc_bind_hash(gconstpointer k)
     const dcerpc_bind_key *key = (const dcerpc_bind_key *)k;
     guint hash;
 
-    hash = GPOINTER_TO_UINT(key->conv);
+    hash = key->conv_index;
     hash += key->ctx_id;
     /* sizeof(guint) might be smaller than sizeof(guint64) */
     hash += (guint)key->transport_salt;
@@ -1796,13 +1796,13 @@ static wmem_map_t *dcerpc_cn_calls = NULL;
 static wmem_map_t *dcerpc_dg_calls = NULL;
 
 typedef struct _dcerpc_cn_call_key {
-    conversation_t *conv;
+    guint32 conv_index;
     guint32 call_id;
     guint64 transport_salt;
 } dcerpc_cn_call_key;
 
 typedef struct _dcerpc_dg_call_key {
-    conversation_t *conv;
+    guint32         conv_index;
     guint32         seqnum;
     e_guid_t        act_id ;
 } dcerpc_dg_call_key;
@@ -1813,7 +1813,7 @@ dcerpc_cn_call_equal(gconstpointer k1, gconstpointer k2)
 {
     const dcerpc_cn_call_key *key1 = (const dcerpc_cn_call_key *)k1;
     const dcerpc_cn_call_key *key2 = (const dcerpc_cn_call_key *)k2;
-    return ((key1->conv == key2->conv)
+    return ((key1->conv_index == key2->conv_index)
             && (key1->call_id == key2->call_id)
             && (key1->transport_salt == key2->transport_salt));
 }
@@ -1823,7 +1823,7 @@ dcerpc_dg_call_equal(gconstpointer k1, gconstpointer k2)
 {
     const dcerpc_dg_call_key *key1 = (const dcerpc_dg_call_key *)k1;
     const dcerpc_dg_call_key *key2 = (const dcerpc_dg_call_key *)k2;
-    return ((key1->conv == key2->conv)
+    return ((key1->conv_index == key2->conv_index)
             && (key1->seqnum == key2->seqnum)
             && ((memcmp(&key1->act_id, &key2->act_id, sizeof (e_guid_t)) == 0)));
 }
@@ -1834,7 +1834,7 @@ dcerpc_cn_call_hash(gconstpointer k)
     const dcerpc_cn_call_key *key = (const dcerpc_cn_call_key *)k;
     guint hash;
 
-    hash = GPOINTER_TO_UINT(key->conv);
+    hash = key->conv_index;
     hash += key->call_id;
     /* sizeof(guint) might be smaller than sizeof(guint64) */
     hash += (guint)key->transport_salt;
@@ -1847,7 +1847,7 @@ static guint
 dcerpc_dg_call_hash(gconstpointer k)
 {
     const dcerpc_dg_call_key *key = (const dcerpc_dg_call_key *)k;
-    return (GPOINTER_TO_UINT(key->conv) + key->seqnum + key->act_id.data1
+    return (key->conv_index + key->seqnum + key->act_id.data1
             + (key->act_id.data2 << 16)    + key->act_id.data3
             + (key->act_id.data4[0] << 24) + (key->act_id.data4[1] << 16)
             + (key->act_id.data4[2] << 8)  + (key->act_id.data4[3] << 0)
@@ -4058,7 +4058,7 @@ dissect_dcerpc_cn_bind(tvbuff_t *tvb, gint offset, packet_info *pinfo,
             dcerpc_bind_value *value;
 
             key = (dcerpc_bind_key *)wmem_alloc(wmem_file_scope(), sizeof (dcerpc_bind_key));
-            key->conv = conv;
+            key->conv_index = conv->conv_index;
             key->ctx_id = ctx_id;
             key->transport_salt = dcerpc_get_transport_salt(pinfo);
 
@@ -4521,7 +4521,7 @@ dissect_dcerpc_cn_rqst(tvbuff_t *tvb, gint offset, packet_info *pinfo,
             dcerpc_bind_key bind_key;
             dcerpc_bind_value *bind_value;
 
-            bind_key.conv = conv;
+            bind_key.conv_index = conv->conv_index;
             bind_key.ctx_id = ctx_id;
             bind_key.transport_salt = dcerpc_get_transport_salt(pinfo);
 
@@ -4530,7 +4530,7 @@ dissect_dcerpc_cn_rqst(tvbuff_t *tvb, gint offset, packet_info *pinfo,
                     dcerpc_cn_call_key call_key;
                     dcerpc_call_value *call_value;
 
-                    call_key.conv = conv;
+                    call_key.conv_index = conv->conv_index;
                     call_key.call_id = hdr->call_id;
                     call_key.transport_salt = dcerpc_get_transport_salt(pinfo);
                     if ((call_value = (dcerpc_call_value *)wmem_map_lookup(dcerpc_cn_calls, &call_key))) {
@@ -4549,7 +4549,7 @@ dissect_dcerpc_cn_rqst(tvbuff_t *tvb, gint offset, packet_info *pinfo,
                        matched table
                     */
                     call_key = (dcerpc_cn_call_key *)wmem_alloc(wmem_file_scope(), sizeof (dcerpc_cn_call_key));
-                    call_key->conv = conv;
+                    call_key->conv_index = conv->conv_index;
                     call_key->call_id = hdr->call_id;
                     call_key->transport_salt = dcerpc_get_transport_salt(pinfo);
 
@@ -4686,7 +4686,7 @@ dissect_dcerpc_cn_resp(tvbuff_t *tvb, gint offset, packet_info *pinfo,
             dcerpc_cn_call_key call_key;
             dcerpc_call_value *call_value;
 
-            call_key.conv = conv;
+            call_key.conv_index = conv->conv_index;
             call_key.call_id = hdr->call_id;
             call_key.transport_salt = dcerpc_get_transport_salt(pinfo);
 
@@ -4853,7 +4853,7 @@ dissect_dcerpc_cn_fault(tvbuff_t *tvb, gint offset, packet_info *pinfo,
             dcerpc_cn_call_key call_key;
             dcerpc_call_value *call_value;
 
-            call_key.conv = conv;
+            call_key.conv_index = conv->conv_index;
             call_key.call_id = hdr->call_id;
             call_key.transport_salt = dcerpc_get_transport_salt(pinfo);
 
@@ -6097,7 +6097,7 @@ dissect_dcerpc_dg_rqst(tvbuff_t *tvb, int offset, packet_info *pinfo,
         dcerpc_dg_call_key *call_key;
 
         call_key = (dcerpc_dg_call_key *)wmem_alloc(wmem_file_scope(), sizeof (dcerpc_dg_call_key));
-        call_key->conv = conv;
+        call_key->conv_index = conv->conv_index;
         call_key->seqnum = hdr->seqnum;
         call_key->act_id = hdr->act_id;
 
@@ -6175,7 +6175,7 @@ dissect_dcerpc_dg_resp(tvbuff_t *tvb, int offset, packet_info *pinfo,
         dcerpc_call_value *call_value;
         dcerpc_dg_call_key call_key;
 
-        call_key.conv = conv;
+        call_key.conv_index = conv->conv_index;
         call_key.seqnum = hdr->seqnum;
         call_key.act_id = hdr->act_id;
 
@@ -6237,7 +6237,7 @@ dissect_dcerpc_dg_ping_ack(tvbuff_t *tvb, int offset, packet_info *pinfo,
     dcerpc_call_value  *call_value;
     dcerpc_dg_call_key  call_key;
 
-    call_key.conv = conv;
+    call_key.conv_index = conv->conv_index;
     call_key.seqnum = hdr->seqnum;
     call_key.act_id = hdr->act_id;
 
@@ -977,7 +977,7 @@ typedef struct l2tpv3_conversation {
 } l2tpv3_conversation_t;
 
 typedef struct l2tpv3_tunnel {
-    l2tpv3_conversation_t *conv;
+    port_type pt;
 
     address  lcce1;
     guint32  lcce1_id;
@@ -1047,7 +1047,7 @@ static void md5_hmac_digest(l2tpv3_tunnel_t *tunnel,
     int remainder;
     int offset = 0;
 
-    if (tunnel->conv->pt == PT_NONE) /* IP encapsulated L2TPv3 */
+    if (tunnel->pt == PT_NONE) /* IP encapsulated L2TPv3 */
         offset = 4;
 
     if (gcry_md_open(&hmac_handle, GCRY_MD_MD5, GCRY_MD_FLAG_HMAC)) {
@@ -1093,7 +1093,7 @@ static void sha1_hmac_digest(l2tpv3_tunnel_t *tunnel,
     int remainder;
     int offset = 0;
 
-    if (tunnel->conv->pt == PT_NONE) /* IP encapsulated L2TPv3 */
+    if (tunnel->pt == PT_NONE) /* IP encapsulated L2TPv3 */
         offset = 4;
 
     if (gcry_md_open(&hmac_handle, GCRY_MD_SHA1, GCRY_MD_FLAG_HMAC)) {
@@ -2864,7 +2864,7 @@ process_l2tpv3_control(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int
             if (msg_type == MESSAGE_TYPE_SCCRQ) {
                 tunnel = &tmp_tunnel;
                 memset(tunnel, 0, sizeof(l2tpv3_tunnel_t));
-                tunnel->conv = l2tp_conv;
+                tunnel->pt = l2tp_conv->pt;
                 copy_address_wmem(wmem_file_scope(), &tunnel->lcce1, &pinfo->src);
                 copy_address_wmem(wmem_file_scope(), &tunnel->lcce2, &pinfo->dst);
             }
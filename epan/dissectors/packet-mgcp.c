@@ -423,7 +423,7 @@ extern guint16 is_asciitpkt(tvbuff_t *tvb);
 typedef struct _mgcp_call_info_key
 {
 	guint32 transid;
-	conversation_t *conversation;
+	guint32 conv_index;
 } mgcp_call_info_key;
 
 static wmem_map_t *mgcp_calls;
@@ -435,7 +435,7 @@ static gint mgcp_call_equal(gconstpointer k1, gconstpointer k2)
 	const mgcp_call_info_key* key2 = (const mgcp_call_info_key*) k2;
 
 	return (key1->transid == key2->transid &&
-	        key1->conversation == key2->conversation);
+	        key1->conv_index == key2->conv_index);
 }
 
 /* Calculate a hash key */
@@ -443,7 +443,7 @@ static guint mgcp_call_hash(gconstpointer k)
 {
 	const mgcp_call_info_key* key = (const mgcp_call_info_key*) k;
 
-	return key->transid  + key->conversation->conv_index;
+	return key->transid  + key->conv_index;
 }
 
 
@@ -1319,7 +1319,7 @@ static void dissect_mgcp_firstline(tvbuff_t *tvb, packet_info *pinfo, proto_tree
 					/* Look only for matching request, if
 					   matching conversation is available. */
 					mgcp_call_key.transid = mi->transid;
-					mgcp_call_key.conversation = conversation;
+					mgcp_call_key.conv_index = conversation->conv_index;
 					mgcp_call = (mgcp_call_t *)wmem_map_lookup(mgcp_calls, &mgcp_call_key);
 					if (mgcp_call)
 					{
@@ -1434,7 +1434,7 @@ static void dissect_mgcp_firstline(tvbuff_t *tvb, packet_info *pinfo, proto_tree
 
 				/* Prepare the key data */
 				mgcp_call_key.transid = mi->transid;
-				mgcp_call_key.conversation = conversation;
+				mgcp_call_key.conv_index = conversation->conv_index;
 
 				/* Look up the request */
 				mgcp_call = (mgcp_call_t *)wmem_map_lookup(mgcp_calls, &mgcp_call_key);
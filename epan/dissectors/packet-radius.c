@@ -425,7 +425,7 @@ typedef struct _radius_call_info_key
 {
 	guint code;
 	guint ident;
-	conversation_t *conversation;
+	guint32 conv_index;
 	nstime_t req_time;
 } radius_call_info_key;
 
@@ -471,7 +471,7 @@ radius_call_equal(gconstpointer k1, gconstpointer k2)
 	const radius_call_info_key *key1 = (const radius_call_info_key *) k1;
 	const radius_call_info_key *key2 = (const radius_call_info_key *) k2;
 
-	if (key1->ident == key2->ident && key1->conversation == key2->conversation) {
+	if (key1->ident == key2->ident && key1->conv_index == key2->conv_index) {
 		if (key1->code == key2->code)
 			return TRUE;
 
@@ -569,7 +569,7 @@ radius_call_hash(gconstpointer k)
 {
 	const radius_call_info_key *key = (const radius_call_info_key *) k;
 
-	return key->ident + key->conversation->conv_index;
+	return key->ident + key->conv_index;
 }
 
 
@@ -2062,7 +2062,7 @@ dissect_radius(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data _
 			/* Prepare the key data */
 			radius_call_key.code = rh.rh_code;
 			radius_call_key.ident = rh.rh_ident;
-			radius_call_key.conversation = conversation;
+			radius_call_key.conv_index = conversation->conv_index;
 			radius_call_key.req_time = pinfo->abs_ts;
 
 			/* Look up the tree of calls with this ident */
@@ -2178,7 +2178,7 @@ dissect_radius(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data _
 			/* Prepare the key data */
 			radius_call_key.code = rh.rh_code;
 			radius_call_key.ident = rh.rh_ident;
-			radius_call_key.conversation = conversation;
+			radius_call_key.conv_index = conversation->conv_index;
 			radius_call_key.req_time = pinfo->abs_ts;
 
 			/* Look up the tree of calls with this ident */
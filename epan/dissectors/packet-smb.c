@@ -7462,7 +7462,7 @@ dissect_session_setup_andx_request(tvbuff_t *tvb, packet_info *pinfo, proto_tree
 			/* If we have found a uid->acct_name mapping, store it */
 			if (!pinfo->fd->visited && si->sip) {
 				int idx = 0;
-				if ((ntlmssph = (const ntlmssp_header_t *)fetch_tapped_data(ntlmssp_tap_id, idx + 1 )) != NULL) {
+				if ((ntlmssph = (const ntlmssp_header_t *)fetch_tapped_data(pinfo, ntlmssp_tap_id, idx + 1 )) != NULL) {
 					if (ntlmssph && (ntlmssph->type == 3)) {
 						smb_uid_t *smb_uid;
 
@@ -3282,7 +3282,7 @@ dissect_smb2_session_setup_request(tvbuff_t *tvb, packet_info *pinfo, proto_tree
 	/* If we have found a uid->acct_name mapping, store it */
 	if (!pinfo->fd->visited) {
 		idx = 0;
-		while ((ntlmssph = (const ntlmssp_header_t *)fetch_tapped_data(ntlmssp_tap_id, idx++)) != NULL) {
+		while ((ntlmssph = (const ntlmssp_header_t *)fetch_tapped_data(pinfo, ntlmssp_tap_id, idx++)) != NULL) {
 			if (ntlmssph && ntlmssph->type == NTLMSSP_AUTH) {
 				si->session = smb2_get_session(si->conv, si->sesid, pinfo, si);
 				si->session->acct_name = wmem_strdup(wmem_file_scope(), ntlmssph->acct_name);
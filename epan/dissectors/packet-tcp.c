@@ -36,6 +36,7 @@
 #include <wsutil/pint.h>
 
 #include "packet-tcp.h"
+#include "tcp_unacked.h"
 #include "packet-ip.h"
 #include "packet-icmp.h"
 
@@ -1528,6 +1529,43 @@ get_tcp_conversation_data(conversation_t *conv, packet_info *pinfo)
     return tcpd;
 }
 
+static void
+tcp_free_flow_data(tcp_flow_t *flow)
+{
+    /* The trees are keyed by 32-bit numbers, not allocated keys */
+    wmem_tree_destroy(flow->multisegment_pdus, FALSE, TRUE);
+
+    if (flow->tcp_analyze_seq_info) {
+        wmem_free(wmem_file_scope(), flow->tcp_analyze_seq_info->segments);
+        wmem_free(wmem_file_scope(), flow->tcp_analyze_seq_info);
+    }
+
+    if (flow->process_info) {
+        wmem_free(wmem_file_scope(), flow->process_info->username);
+        wmem_free(wmem_file_scope(), flow->process_info->command);
+        wmem_free(wmem_file_scope(), flow->process_info);
+    }
+}
+
+/* Release the data of a conversation that conversation_expire() frees */
+static void
+tcp_expire_conversation_data(conversation_t *conv _U_, void *proto_data)
+{
+    struct tcp_analysis *tcpd = (struct tcp_analysis *)proto_data;
+
+    /*
+     * An MPTCP connection keeps pointers to the analysis of each of
+     * its subflows, so leave those for the end of the file.
+     */
+    if (tcpd->mptcp_analysis || tcpd->flow1.mptcp_subflow || tcpd->flow2.mptcp_subflow)
+        return;
+
+    tcp_free_flow_data(&tcpd->flow1);
+    tcp_free_flow_data(&tcpd->flow2);
+    wmem_tree_destroy(tcpd->acked_table, FALSE, TRUE);
+    wmem_free(wmem_file_scope(), tcpd);
+}
+
 /* Attach process info to a flow */
 /* XXX - We depend on the TCP dissector finding the conversation first */
 void
@@ -1830,13 +1868,11 @@ tcp_analyze_get_acked_struct(guint32 frame, guint32 seq, guint32 ack, gboolean c
 }
 
 
-/* fwd contains a list of all segments processed but not yet ACKed in the
+/* fwd contains the segments processed but not yet ACKed in the
  *     same direction as the current segment.
- * rev contains a list of all segments received but not yet ACKed in the
+ * rev contains the segments received but not yet ACKed in the
  *     opposite direction to the current segment.
  *
- * New segments are always added to the head of the fwd/rev lists.
- *
  * Changes below should be synced with ChAdvTCPAnalysis in the User's
  * Guide: docbook/wsug_src/WSUG_chapter_advanced.adoc
  */
@@ -1844,18 +1880,25 @@ static void
 tcp_analyze_sequence_number(packet_info *pinfo, guint32 seq, guint32 ack, guint32 seglen, guint16 flags, guint32 window, struct tcp_analysis *tcpd)
 {
     tcp_unacked_t *ual=NULL;
-    tcp_unacked_t *prevual=NULL;
+    tcp_analyze_seq_flow_info_t *revinfo;
     guint32 nextseq;
     int ackcount;
+    gboolean acked_exact;
 
 #if 0
+    guint32 i;
+
     printf("\nanalyze_sequence numbers   frame:%u\n",pinfo->num);
     printf("FWD list lastflags:0x%04x base_seq:%u: nextseq:%u lastack:%u\n",tcpd->fwd->lastsegmentflags,tcpd->fwd->base_seq,tcpd->fwd->tcp_analyze_seq_info->nextseq,tcpd->rev->tcp_analyze_seq_info->lastack);
-    for(ual=tcpd->fwd->tcp_analyze_seq_info->segments; ual; ual=ual->next)
+    for(i=0; i<tcpd->fwd->tcp_analyze_seq_info->segment_count; i++) {
+            ual=TCP_UNACKED(tcpd->fwd->tcp_analyze_seq_info, i);
             printf("Frame:%d Seq:%u Nextseq:%u\n",ual->frame,ual->seq,ual->nextseq);
+    }
     printf("REV list lastflags:0x%04x base_seq:%u nextseq:%u lastack:%u\n",tcpd->rev->lastsegmentflags,tcpd->rev->base_seq,tcpd->rev->tcp_analyze_seq_info->nextseq,tcpd->fwd->tcp_analyze_seq_info->lastack);
-    for(ual=tcpd->rev->tcp_analyze_seq_info->segments; ual; ual=ual->next)
+    for(i=0; i<tcpd->rev->tcp_analyze_seq_info->segment_count; i++) {
+            ual=TCP_UNACKED(tcpd->rev->tcp_analyze_seq_info, i);
             printf("Frame:%d Seq:%u Nextseq:%u\n",ual->frame,ual->seq,ual->nextseq);
+    }
 #endif
 
     if (!tcpd) {
@@ -2193,23 +2236,18 @@ finished_fwd:
 finished_checking_retransmission_type:
 
     nextseq = seq+seglen;
-    if ((seglen || flags&(TH_SYN|TH_FIN)) && tcpd->fwd->tcp_analyze_seq_info->segment_count < TCP_MAX_UNACKED_SEGMENTS) {
-        /* Add this new sequence number to the fwd list.  But only if there
-         * aren't "too many" unacked segments (e.g., we're not seeing the ACKs).
-         */
-        ual = wmem_new(wmem_file_scope(), tcp_unacked_t);
-        ual->next=tcpd->fwd->tcp_analyze_seq_info->segments;
-        tcpd->fwd->tcp_analyze_seq_info->segments=ual;
-        tcpd->fwd->tcp_analyze_seq_info->segment_count++;
-        ual->frame=pinfo->num;
-        ual->seq=seq;
-        ual->ts=pinfo->abs_ts;
-
+    if (seglen || flags&(TH_SYN|TH_FIN)) {
         /* next sequence number is seglen bytes away, plus SYN/FIN which counts as one byte */
         if( (flags&(TH_SYN|TH_FIN)) ) {
             nextseq+=1;
         }
-        ual->nextseq=nextseq;
+
+        /* Add this new sequence number to the fwd list.  If we have never
+         * seen the other side, we're not going to see the ACKs either, so
+         * don't keep "too many" unacked segments.
+         */
+        tcp_unacked_add(tcpd->fwd->tcp_analyze_seq_info, pinfo->num, seq, nextseq, &pinfo->abs_ts,
+                        tcpd->rev->tcp_analyze_seq_info->lastack ? G_MAXUINT32 : TCP_MAX_UNACKED_SEGMENTS);
     }
 
     /* Store the highest number seen so far for nextseq so we can detect
@@ -2256,32 +2294,28 @@ finished_checking_retransmission_type:
     /* remove all segments this ACKs and we don't need to keep around any more
      */
     ackcount=0;
-    prevual = NULL;
-    ual = tcpd->rev->tcp_analyze_seq_info->segments;
-    while(ual) {
-        tcp_unacked_t *tmpual;
+    acked_exact=FALSE;
+    revinfo=tcpd->rev->tcp_analyze_seq_info;
+    while(revinfo->segment_count) {
+        ual = TCP_UNACKED(revinfo, 0);
+
+        /* If this acknowledges a segment prior to this one, leave this
+         * segment and the ones after it alone */
+        if (GT_SEQ(ual->nextseq,ack)) {
+            break;
+        }
 
-        /* If this ack matches the segment, process accordingly */
-        if(ack==ual->nextseq) {
+        /* If this ack matches the segment, process accordingly.  The first
+         * matching segment is the one seen earliest. */
+        if(ack==ual->nextseq && !acked_exact) {
             tcp_analyze_get_acked_struct(pinfo->num, seq, ack, TRUE, tcpd);
             tcpd->ta->frame_acked=ual->frame;
             nstime_delta(&tcpd->ta->ts, &pinfo->abs_ts, &ual->ts);
-        }
-        /* If this acknowledges part of the segment, adjust the segment info for the acked part */
-        else if (GT_SEQ(ack, ual->seq) && LE_SEQ(ack, ual->nextseq)) {
-            ual->seq = ack;
-            continue;
-        }
-        /* If this acknowledges a segment prior to this one, leave this segment alone and move on */
-        else if (GT_SEQ(ual->nextseq,ack)) {
-            prevual = ual;
-            ual = ual->next;
-            continue;
+            acked_exact=TRUE;
         }
 
         /* This segment is old, or an exact match.  Delete the segment from the list */
         ackcount++;
-        tmpual=ual->next;
 
         if (tcpd->rev->scps_capable) {
           /* Track largest segment successfully sent for SNACK analysis*/
@@ -2290,35 +2324,24 @@ finished_checking_retransmission_type:
           }
         }
 
-        if (!prevual) {
-            tcpd->rev->tcp_analyze_seq_info->segments = tmpual;
-        }
-        else{
-            prevual->next = tmpual;
-        }
-        wmem_free(wmem_file_scope(), ual);
-        ual = tmpual;
-        tcpd->rev->tcp_analyze_seq_info->segment_count--;
+        tcp_unacked_drop_first(revinfo);
     }
 
+    /* If this acknowledges part of a segment, adjust the segment info for
+     * the acked part.
+     */
+    tcp_unacked_ack_partial(revinfo, ack);
+
     /* how many bytes of data are there in flight after this frame
      * was sent
      */
-    ual=tcpd->fwd->tcp_analyze_seq_info->segments;
-    if (tcp_track_bytes_in_flight && seglen!=0 && ual && tcpd->fwd->valid_bif) {
+    if (tcp_track_bytes_in_flight && seglen!=0 && tcpd->fwd->tcp_analyze_seq_info->segment_count && tcpd->fwd->valid_bif) {
+        tcp_analyze_seq_flow_info_t *fwdinfo = tcpd->fwd->tcp_analyze_seq_info;
         guint32 first_seq, last_seq, in_flight;
 
-        first_seq = ual->seq - tcpd->fwd->base_seq;
-        last_seq = ual->nextseq - tcpd->fwd->base_seq;
-        while (ual) {
-            if ((ual->nextseq-tcpd->fwd->base_seq)>last_seq) {
-                last_seq = ual->nextseq-tcpd->fwd->base_seq;
-            }
-            if ((ual->seq-tcpd->fwd->base_seq)<first_seq) {
-                first_seq = ual->seq-tcpd->fwd->base_seq;
-            }
-            ual = ual->next;
-        }
+        /* The highest nextseq is at the end of the ring. */
+        first_seq = tcp_unacked_first_seq(fwdinfo, tcpd->fwd->base_seq);
+        last_seq = TCP_UNACKED(fwdinfo, fwdinfo->segment_count - 1)->nextseq - tcpd->fwd->base_seq;
         in_flight = last_seq-first_seq;
 
         if (in_flight>0 && in_flight<2000000000) {
@@ -7792,6 +7815,7 @@ proto_register_tcp(void)
         &tcp_display_process_info);
 
     register_init_routine(tcp_init);
+    conversation_register_expire_routine(proto_tcp, tcp_expire_conversation_data);
     reassembly_table_register(&tcp_reassembly_table,
                           &addresses_ports_reassembly_table_functions);
 
@@ -143,7 +143,6 @@ extern struct tcp_multisegment_pdu *
 pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, wmem_tree_t *multisegment_pdus);
 
 typedef struct _tcp_unacked_t {
-	struct _tcp_unacked_t *next;
 	guint32 frame;
 	guint32	seq;
 	guint32	nextseq;
@@ -289,8 +288,12 @@ typedef enum {
  * is enabled, so save the memory when it isn't
  */
 typedef struct tcp_analyze_seq_flow_info_t {
-	tcp_unacked_t *segments;/* List of segments for which we haven't seen an ACK */
-	guint16 segment_count;	/* How many unacked segments we're currently storing */
+	tcp_unacked_t *segments;/* Ring of segments for which we haven't seen an ACK,
+				 * ordered by nextseq */
+	guint32 segment_first;	/* Index in the ring of the segment with the lowest nextseq */
+	guint32 segment_count;	/* How many unacked segments we're currently storing */
+	guint32 segment_alloc;	/* Size of the ring, always a power of two */
+	guint32 segment_maxlen;	/* Longest segment (nextseq - seq) stored so far */
     guint32 lastack;	/* Last seen ack for the reverse flow */
 	nstime_t lastacktime;	/* Time of the last ack packet */
 	guint32 lastnondupack;	/* frame number of last seen non dupack */
@@ -321,7 +324,10 @@ typedef struct tcp_process_info_t {
 typedef struct _tcp_flow_t {
 	guint8 static_flags; /* true if base seq set */
 	guint32 base_seq;	/* base seq number (used by relative sequence numbers)*/
-#define TCP_MAX_UNACKED_SEGMENTS 1000 /* The most unacked segments we'll store */
+#define TCP_MAX_UNACKED_SEGMENTS 1000 /* The most unacked segments we'll store
+                                       * before seeing the other direction */
+#define TCP_MAX_UNACKED_SPAN 0x40000000 /* The largest window (RFC 7323), beyond
+                                          * which segments can't still be unacked */
 	guint32 fin;		/* frame number of the final FIN */
 	guint32 window;		/* last seen window */
 	gint16	win_scale;	/* -1 is we don't know, -2 is window scaling is not used */
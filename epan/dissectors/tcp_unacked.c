@@ -0,0 +1,154 @@
+/* tcp_unacked.c
+ * Ring of the unacked segments of a TCP flow, used by the TCP dissector's
+ * sequence analysis
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <epan/wmem/wmem.h>
+
+#include "tcp_unacked.h"
+
+static void
+tcp_unacked_grow(tcp_analyze_seq_flow_info_t *info)
+{
+    tcp_unacked_t *segments;
+    guint32 alloc, i;
+
+    alloc = info->segment_alloc ? info->segment_alloc * 2 : 16;
+    segments = wmem_alloc_array(wmem_file_scope(), tcp_unacked_t, alloc);
+    for (i = 0; i < info->segment_count; i++) {
+        segments[i] = *TCP_UNACKED(info, i);
+    }
+    wmem_free(wmem_file_scope(), info->segments);
+
+    info->segments = segments;
+    info->segment_first = 0;
+    info->segment_alloc = alloc;
+}
+
+void
+tcp_unacked_drop_first(tcp_analyze_seq_flow_info_t *info)
+{
+    info->segment_first = (info->segment_first + 1) & (info->segment_alloc - 1);
+    info->segment_count--;
+}
+
+void
+tcp_unacked_add(tcp_analyze_seq_flow_info_t *info, guint32 frame, guint32 seq, guint32 nextseq, const nstime_t *ts, guint32 max_count)
+{
+    tcp_unacked_t *ual;
+    guint32 pos, lo, hi, mid, i;
+
+    if (info->segment_count == info->segment_alloc) {
+        tcp_unacked_grow(info);
+    }
+
+    /* Find where it goes: after every segment with a nextseq not above its
+     * own.  New data is normally the highest yet, so check that first. */
+    pos = info->segment_count;
+    if (pos && LT_SEQ(nextseq, TCP_UNACKED(info, pos - 1)->nextseq)) {
+        lo = 0;
+        hi = pos - 1;
+        while (lo < hi) {
+            mid = lo + (hi - lo) / 2;
+            if (GT_SEQ(TCP_UNACKED(info, mid)->nextseq, nextseq))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        pos = lo;
+
+        /* Move whichever side of the ring is shorter. */
+        if (pos < info->segment_count / 2) {
+            info->segment_first = (info->segment_first - 1) & (info->segment_alloc - 1);
+            for (i = 0; i < pos; i++) {
+                *TCP_UNACKED(info, i) = *TCP_UNACKED(info, i + 1);
+            }
+        } else {
+            for (i = info->segment_count; i > pos; i--) {
+                *TCP_UNACKED(info, i) = *TCP_UNACKED(info, i - 1);
+            }
+        }
+    }
+    info->segment_count++;
+
+    ual = TCP_UNACKED(info, pos);
+    ual->frame = frame;
+    ual->seq = seq;
+    ual->nextseq = nextseq;
+    ual->ts = *ts;
+
+    if (nextseq - seq > info->segment_maxlen) {
+        info->segment_maxlen = nextseq - seq;
+    }
+
+    /* Forget the oldest data if there's more outstanding than any window
+     * allows (or, while we haven't seen the other side, than we are willing
+     * to keep); it is never going to be acked. */
+    while (info->segment_count > max_count ||
+           TCP_UNACKED(info, info->segment_count - 1)->nextseq - TCP_UNACKED(info, 0)->nextseq > TCP_MAX_UNACKED_SPAN) {
+        tcp_unacked_drop_first(info);
+    }
+}
+
+void
+tcp_unacked_ack_partial(tcp_analyze_seq_flow_info_t *info, guint32 ack)
+{
+    tcp_unacked_t *ual;
+    guint32 i;
+
+    /* Only segments ending within segment_maxlen of the ack can start
+     * before it. */
+    for (i = 0; i < info->segment_count; i++) {
+        ual = TCP_UNACKED(info, i);
+        if (GE_SEQ(ual->nextseq - info->segment_maxlen, ack)) {
+            break;
+        }
+        if (GT_SEQ(ack, ual->seq)) {
+            ual->seq = ack;
+        }
+    }
+}
+
+guint32
+tcp_unacked_first_seq(const tcp_analyze_seq_flow_info_t *info, guint32 base_seq)
+{
+    const tcp_unacked_t *first, *cur;
+    guint32 first_seq, i;
+
+    /* The lowest seq belongs to a segment ending within segment_maxlen of
+     * the first one. */
+    first = TCP_UNACKED(info, 0);
+    first_seq = first->seq - base_seq;
+    for (i = 1; i < info->segment_count; i++) {
+        cur = TCP_UNACKED(info, i);
+        if (GE_SEQ(cur->nextseq - info->segment_maxlen, first->nextseq)) {
+            break;
+        }
+        if ((cur->seq - base_seq) < first_seq) {
+            first_seq = cur->seq - base_seq;
+        }
+    }
+
+    return first_seq;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
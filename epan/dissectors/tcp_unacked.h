@@ -0,0 +1,58 @@
+/* tcp_unacked.h
+ * Ring of the unacked segments of a TCP flow, used by the TCP dissector's
+ * sequence analysis
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __TCP_UNACKED_H__
+#define __TCP_UNACKED_H__
+
+#include <glib.h>
+
+#include "packet-tcp.h"
+
+/* The unacked segments of a flow are kept in a ring ordered by nextseq, so
+ * an ACK only has to look at the segments it covers (at the front of the
+ * ring) and the few it may partially cover right after them; no segment
+ * is longer than segment_maxlen, so nothing further along can start
+ * before the ACK.  Segments with the same nextseq stay in the order they
+ * were seen.
+ */
+#define TCP_UNACKED(info, i) \
+    (&(info)->segments[((info)->segment_first + (i)) & ((info)->segment_alloc - 1)])
+
+/* Add a segment, then forget the oldest ones if there are more than
+ * max_count, or more data than any window allows. */
+void tcp_unacked_add(tcp_analyze_seq_flow_info_t *info, guint32 frame,
+    guint32 seq, guint32 nextseq, const nstime_t *ts, guint32 max_count);
+
+/* Remove the segment with the lowest nextseq. */
+void tcp_unacked_drop_first(tcp_analyze_seq_flow_info_t *info);
+
+/* Mark the part of each segment below ack as acked, once the segments the
+ * ACK covers in full have been dropped. */
+void tcp_unacked_ack_partial(tcp_analyze_seq_flow_info_t *info, guint32 ack);
+
+/* The lowest seq of any segment, relative to base_seq.  There must be at
+ * least one segment. */
+guint32 tcp_unacked_first_seq(const tcp_analyze_seq_flow_info_t *info, guint32 base_seq);
+
+#endif /* __TCP_UNACKED_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
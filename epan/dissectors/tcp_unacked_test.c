@@ -0,0 +1,324 @@
+/* tcp_unacked_test.c
+ * Standalone program to test, and time, the ring of unacked TCP segments.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <epan/wmem/wmem.h>
+
+#include "tcp_unacked.h"
+
+#define NUM_FLOWS 2000
+#define NUM_FRAMES 400
+
+/*
+ * The sequence analysis used to keep the unacked segments in a list, newest
+ * first, and walk all of it on every ACK and for bytes in flight.  This is
+ * that list, to check the ring against.
+ */
+typedef struct _list_unacked_t {
+    struct _list_unacked_t *next;
+    guint32 frame;
+    guint32 seq;
+    guint32 nextseq;
+} list_unacked_t;
+
+static gboolean failed = FALSE;
+
+static guint32 rand_state = 1;
+
+static guint32
+next_rand(void)
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return rand_state >> 8;
+}
+
+static void
+list_add(list_unacked_t **head, guint32 frame, guint32 seq, guint32 nextseq)
+{
+    list_unacked_t *ual = g_new(list_unacked_t, 1);
+
+    ual->next = *head;
+    ual->frame = frame;
+    ual->seq = seq;
+    ual->nextseq = nextseq;
+    *head = ual;
+}
+
+/* Returns the frame of the segment the ACK matches exactly, or 0. */
+static guint32
+list_ack(list_unacked_t **head, guint32 ack)
+{
+    list_unacked_t *prev = NULL, *ual = *head, *next;
+    guint32 frame_acked = 0;
+
+    while (ual) {
+        if (ack == ual->nextseq) {
+            frame_acked = ual->frame;
+        } else if (GT_SEQ(ack, ual->seq) && LE_SEQ(ack, ual->nextseq)) {
+            ual->seq = ack;
+            continue;
+        } else if (GT_SEQ(ual->nextseq, ack)) {
+            prev = ual;
+            ual = ual->next;
+            continue;
+        }
+
+        next = ual->next;
+        if (prev)
+            prev->next = next;
+        else
+            *head = next;
+        g_free(ual);
+        ual = next;
+    }
+
+    return frame_acked;
+}
+
+/* The same steps as tcp_analyze_sequence_number(). */
+static guint32
+ring_ack(tcp_analyze_seq_flow_info_t *info, guint32 ack)
+{
+    tcp_unacked_t *ual;
+    guint32 frame_acked = 0;
+
+    while (info->segment_count) {
+        ual = TCP_UNACKED(info, 0);
+        if (GT_SEQ(ual->nextseq, ack))
+            break;
+        if (ack == ual->nextseq && !frame_acked)
+            frame_acked = ual->frame;
+        tcp_unacked_drop_first(info);
+    }
+    tcp_unacked_ack_partial(info, ack);
+
+    return frame_acked;
+}
+
+static gint
+compare_frames(gconstpointer a, gconstpointer b)
+{
+    const tcp_unacked_t *ua = (const tcp_unacked_t *)a;
+    const tcp_unacked_t *ub = (const tcp_unacked_t *)b;
+
+    return ua->frame < ub->frame ? -1 : ua->frame > ub->frame;
+}
+
+/* Both hold the same segments, and give the same bytes in flight. */
+static void
+compare(int flow, guint32 frame, const list_unacked_t *head, const tcp_analyze_seq_flow_info_t *info, guint32 base_seq)
+{
+    tcp_unacked_t list_segments[NUM_FRAMES], ring_segments[NUM_FRAMES];
+    const list_unacked_t *ual;
+    guint32 count = 0, i, first_seq = 0, last_seq = 0;
+
+    for (ual = head; ual; ual = ual->next) {
+        list_segments[count].frame = ual->frame;
+        list_segments[count].seq = ual->seq;
+        list_segments[count].nextseq = ual->nextseq;
+        if (count == 0 || ual->seq - base_seq < first_seq)
+            first_seq = ual->seq - base_seq;
+        if (count == 0 || ual->nextseq - base_seq > last_seq)
+            last_seq = ual->nextseq - base_seq;
+        count++;
+    }
+
+    if (count != info->segment_count) {
+        printf("Failed: flow %d frame %u: %u unacked segments, expected %u\n",
+            flow, frame, info->segment_count, count);
+        failed = TRUE;
+        return;
+    }
+    if (count == 0)
+        return;
+
+    for (i = 0; i < count; i++) {
+        ring_segments[i] = *TCP_UNACKED(info, i);
+        if (i > 0 && GT_SEQ(ring_segments[i - 1].nextseq, ring_segments[i].nextseq)) {
+            printf("Failed: flow %d frame %u: the ring isn't ordered by nextseq\n", flow, frame);
+            failed = TRUE;
+        }
+    }
+    qsort(list_segments, count, sizeof(tcp_unacked_t), compare_frames);
+    qsort(ring_segments, count, sizeof(tcp_unacked_t), compare_frames);
+    for (i = 0; i < count; i++) {
+        if (list_segments[i].frame != ring_segments[i].frame ||
+            list_segments[i].seq != ring_segments[i].seq ||
+            list_segments[i].nextseq != ring_segments[i].nextseq) {
+            printf("Failed: flow %d frame %u: segment from frame %u is %u-%u, expected frame %u %u-%u\n",
+                flow, frame, ring_segments[i].frame, ring_segments[i].seq, ring_segments[i].nextseq,
+                list_segments[i].frame, list_segments[i].seq, list_segments[i].nextseq);
+            failed = TRUE;
+            return;
+        }
+    }
+
+    if (tcp_unacked_first_seq(info, base_seq) != first_seq ||
+        TCP_UNACKED(info, count - 1)->nextseq - base_seq != last_seq) {
+        printf("Failed: flow %d frame %u: bytes in flight %u-%u, expected %u-%u\n",
+            flow, frame, tcp_unacked_first_seq(info, base_seq),
+            TCP_UNACKED(info, count - 1)->nextseq - base_seq, first_seq, last_seq);
+        failed = TRUE;
+    }
+}
+
+/*
+ * Random flows of new data, retransmissions of any part of the unacked data
+ * and ACKs of anything up to the newest data, starting anywhere in the
+ * sequence space so that some of them wrap.
+ */
+static void
+check_random_flows(void)
+{
+    static const nstime_t ts = { 0, 0 };
+    tcp_analyze_seq_flow_info_t info;
+    list_unacked_t *head, *next;
+    guint32 base_seq, nextseq, ack, seq, len, frame, frame_acked;
+    int flow;
+
+    for (flow = 0; flow < NUM_FLOWS && !failed; flow++) {
+        memset(&info, 0, sizeof(info));
+        head = NULL;
+        base_seq = next_rand() * 2654435761U;
+        nextseq = ack = base_seq;
+
+        for (frame = 1; frame < NUM_FRAMES && !failed; frame++) {
+            if (next_rand() % 3 != 0) {
+                len = 1 + next_rand() % 3000;
+                if (next_rand() % 5 == 0) {
+                    seq = ack + next_rand() % (nextseq - ack + 1);
+                } else {
+                    seq = nextseq;
+                    nextseq += len;
+                }
+                list_add(&head, frame, seq, seq + len);
+                tcp_unacked_add(&info, frame, seq, seq + len, &ts, G_MAXUINT32);
+            } else {
+                if (nextseq != ack)
+                    ack += next_rand() % (nextseq - ack + 1);
+                frame_acked = list_ack(&head, ack);
+                if (ring_ack(&info, ack) != frame_acked) {
+                    printf("Failed: flow %d frame %u: ACK of frame %u, expected frame %u\n",
+                        flow, frame, ring_ack(&info, ack), frame_acked);
+                    failed = TRUE;
+                }
+            }
+            compare(flow, frame, head, &info, base_seq);
+        }
+
+        for (; head; head = next) {
+            next = head->next;
+            g_free(head);
+        }
+    }
+}
+
+/* What's dropped when there's more outstanding than we keep. */
+static void
+check_limits(void)
+{
+    static const nstime_t ts = { 0, 0 };
+    tcp_analyze_seq_flow_info_t info;
+    guint32 frame;
+
+    /* While the other side hasn't been seen, only the newest segments. */
+    memset(&info, 0, sizeof(info));
+    for (frame = 1; frame <= TCP_MAX_UNACKED_SEGMENTS + 500; frame++)
+        tcp_unacked_add(&info, frame, frame * 100, frame * 100 + 100, &ts, TCP_MAX_UNACKED_SEGMENTS);
+    if (info.segment_count != TCP_MAX_UNACKED_SEGMENTS || TCP_UNACKED(&info, 0)->frame != 501) {
+        printf("Failed: %u segments kept from frame %u, expected %u from frame 501\n",
+            info.segment_count, TCP_UNACKED(&info, 0)->frame, TCP_MAX_UNACKED_SEGMENTS);
+        failed = TRUE;
+    }
+
+    /* Otherwise, no more than the largest window. */
+    memset(&info, 0, sizeof(info));
+    tcp_unacked_add(&info, 1, 0, 1000, &ts, G_MAXUINT32);
+    tcp_unacked_add(&info, 2, 1000, 2000, &ts, G_MAXUINT32);
+    tcp_unacked_add(&info, 3, TCP_MAX_UNACKED_SPAN + 1500, TCP_MAX_UNACKED_SPAN + 2000, &ts, G_MAXUINT32);
+    if (info.segment_count != 2 || TCP_UNACKED(&info, 0)->frame != 2) {
+        printf("Failed: %u segments kept from frame %u, expected 2 from frame 2\n",
+            info.segment_count, TCP_UNACKED(&info, 0)->frame);
+        failed = TRUE;
+    }
+}
+
+/* Report how long a window of 100k segments takes; this doesn't check it. */
+static void
+time_window(void)
+{
+    static const nstime_t ts = { 0, 0 };
+    tcp_analyze_seq_flow_info_t info;
+    guint32 frame, seq = 0;
+    gint64 start_time;
+
+    memset(&info, 0, sizeof(info));
+    start_time = g_get_monotonic_time();
+    for (frame = 1; frame <= 100000; frame++) {
+        tcp_unacked_add(&info, frame, seq, seq + 1448, &ts, G_MAXUINT32);
+        seq += 1448;
+    }
+    for (; frame <= 2100000; frame++) {
+        tcp_unacked_add(&info, frame, seq, seq + 1448, &ts, G_MAXUINT32);
+        seq += 1448;
+        tcp_unacked_drop_first(&info);
+    }
+    printf("2M segments through a window of %u: %.3f s\n", info.segment_count,
+        (g_get_monotonic_time() - start_time) / 1000000.0);
+}
+
+int
+main(int argc, char **argv)
+{
+    gboolean time_it = FALSE;
+
+    if (argc == 2 && strcmp(argv[1], "--time") == 0) {
+        time_it = TRUE;
+    } else if (argc != 1) {
+        fprintf(stderr, "Usage: %s [--time]\n", argv[0]);
+        exit(1);
+    }
+
+    wmem_init();
+    wmem_init_scopes();
+    wmem_enter_file_scope();
+
+    check_random_flows();
+    check_limits();
+    if (!failed)
+        printf("Passed unacked TCP segment tests\n");
+    if (time_it)
+        time_window();
+
+    wmem_leave_file_scope();
+    wmem_cleanup_scopes();
+    wmem_cleanup();
+
+    exit(failed ? 1 : 0);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
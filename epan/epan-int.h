@@ -0,0 +1,30 @@
+/* epan-int.h
+ *
+ * Structures that only libwireshark should be accessing directly.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __EPAN_INT_H__
+#define __EPAN_INT_H__
+
+#include <epan/epan.h>
+
+struct tap_packet_queue;
+
+/*
+ * State belonging to one epan session.  Whatever a dissection changes
+ * while it runs should live here, rather than in globals, so that
+ * dissections in separate sessions don't interfere with each other.
+ */
+struct epan_session {
+	struct packet_provider_data *prov;	/* packet provider data for this session */
+	struct packet_provider_funcs funcs;	/* functions using that data */
+	struct tap_packet_queue *tap_queue;	/* data queued for tap listeners by the packet being dissected */
+};
+
+#endif /* __EPAN_INT_H__ */
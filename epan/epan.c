@@ -25,6 +25,7 @@
 #include <epan/exceptions.h>
 
 #include "epan.h"
+#include "epan-int.h"
 #include "epan/frame_data.h"
 
 #include "dfilter/dfilter.h"
@@ -366,11 +367,6 @@ epan_cleanup(void)
 	wmem_cleanup();
 }
 
-struct epan_session {
-	struct packet_provider_data *prov;	/* packet provider data for this session */
-	struct packet_provider_funcs funcs;	/* functions using that data */
-};
-
 epan_t *
 epan_new(struct packet_provider_data *prov,
     const struct packet_provider_funcs *funcs)
@@ -427,6 +423,15 @@ epan_get_frame_ts(const epan_t *session, guint32 frame_num)
 	return abs_ts;
 }
 
+void
+epan_get_shift_offset(const epan_t *session, guint32 frame_num, nstime_t *offset)
+{
+	if (session && session->funcs.get_shift_offset)
+		session->funcs.get_shift_offset(session->prov, frame_num, offset);
+	else
+		nstime_set_zero(offset);
+}
+
 void
 epan_free(epan_t *session)
 {
@@ -434,6 +439,7 @@ epan_free(epan_t *session)
 		/* XXX, it should take session as param */
 		cleanup_dissection();
 
+		tap_queue_free(session->tap_queue);
 		g_slice_free(epan_t, session);
 	}
 }
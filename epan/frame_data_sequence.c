@@ -32,6 +32,7 @@
 struct _frame_data_sequence {
   guint32      count;           /* Total number of frames */
   void        *ptree_root;      /* Pointer to the root node */
+  GHashTable  *shift_offsets;   /* Frame number -> nstime_t, for time-shifted frames */
 };
 
 /*
@@ -55,6 +56,7 @@ new_frame_data_sequence(void)
   fds = (frame_data_sequence *)g_malloc(sizeof *fds);
   fds->count = 0;
   fds->ptree_root = NULL;
+  fds->shift_offsets = NULL;
   return fds;
 }
 
@@ -307,10 +309,58 @@ free_frame_data_sequence(frame_data_sequence *fds)
     free_frame_data_array(fds->ptree_root, fds->count, levels, TRUE);
   }
 
+  if (fds->shift_offsets) {
+    g_hash_table_destroy(fds->shift_offsets);
+  }
+
   /* free the header struct */
   g_free(fds);
 }
 
+/*
+ * The time shift offsets are kept here rather than in each frame_data,
+ * as most captures never have their time stamps shifted and the offset
+ * would otherwise cost 16 bytes for every frame.
+ */
+void
+frame_data_sequence_get_shift_offset(frame_data_sequence *fds, guint32 num,
+                                     nstime_t *offset)
+{
+  nstime_t *shift_offset = NULL;
+
+  if (fds->shift_offsets) {
+    shift_offset = (nstime_t *)g_hash_table_lookup(fds->shift_offsets,
+                                                   GUINT_TO_POINTER(num));
+  }
+  if (shift_offset) {
+    *offset = *shift_offset;
+  } else {
+    nstime_set_zero(offset);
+  }
+}
+
+void
+frame_data_sequence_set_shift_offset(frame_data_sequence *fds, guint32 num,
+                                     const nstime_t *offset)
+{
+  nstime_t *shift_offset;
+
+  if (offset->secs == 0 && offset->nsecs == 0) {
+    if (fds->shift_offsets) {
+      g_hash_table_remove(fds->shift_offsets, GUINT_TO_POINTER(num));
+    }
+    return;
+  }
+
+  if (fds->shift_offsets == NULL) {
+    fds->shift_offsets = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                               NULL, g_free);
+  }
+  shift_offset = g_new(nstime_t, 1);
+  *shift_offset = *offset;
+  g_hash_table_replace(fds->shift_offsets, GUINT_TO_POINTER(num), shift_offset);
+}
+
 void
 find_and_mark_frame_depended_upon(gpointer data, gpointer user_data)
 {
@@ -33,6 +33,17 @@ WS_DLL_PUBLIC frame_data *frame_data_sequence_find(frame_data_sequence *fds,
  */
 WS_DLL_PUBLIC void free_frame_data_sequence(frame_data_sequence *fds);
 
+/*
+ * Get or set how much the time stamp of the specified frame has been
+ * shifted from the one in the capture file; it's zero for frames whose
+ * time stamp hasn't been shifted.
+ */
+WS_DLL_PUBLIC void frame_data_sequence_get_shift_offset(frame_data_sequence *fds,
+    guint32 num, nstime_t *offset);
+
+WS_DLL_PUBLIC void frame_data_sequence_set_shift_offset(frame_data_sequence *fds,
+    guint32 num, const nstime_t *offset);
+
 WS_DLL_PUBLIC void find_and_mark_frame_depended_upon(gpointer data, gpointer user_data);
 
 
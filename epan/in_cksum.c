@@ -13,7 +13,10 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
+#include <wsutil/ws_sse2.h>
 
 #include <epan/tvbuff.h>
 #include <epan/in_cksum.h>
@@ -23,103 +26,183 @@
  *
  * This routine is very heavily used in the network
  * code and should be modified for each CPU to be as fast as possible.
+ *
+ * As RFC 1071 points out, the one's complement sum of 16-bit words can
+ * be computed by adding wider words and folding the carries back in at
+ * the end, since 2^16, 2^32 and 2^48 are all 1 modulo 2^16-1.  We add
+ * 32-bit words into a 64-bit accumulator, or, with SSE2, 16-bit words
+ * into 32-bit lanes, and only fold once per buffer.
  */
 
-#define ADDCARRY(x)  {if ((x) > 65535) (x) -= 65535;}
-#define REDUCE {l_util.l = sum; sum = l_util.s[0] + l_util.s[1]; ADDCARRY(sum);}
+/* Fold a 64-bit sum of host-byte-order words to 16 bits. */
+static inline guint32
+in_cksum_fold(guint64 sum)
+{
+	sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+	sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	return (guint32)sum;
+}
 
-int
-in_cksum(const vec_t *vec, int veclen)
+/*
+ * Return the one's complement sum, folded to 16 bits but not complemented,
+ * of the 16-bit host-byte-order words of a buffer, padding an odd final
+ * byte with a zero byte.
+ */
+static guint32
+in_cksum_sum(const guint8 *p, int len)
 {
-	register const guint16 *w;
-	register int sum = 0;
-	register int mlen = 0;
-	int byte_swapped = 0;
-
-	union {
-		guint8	c[2];
-		guint16	s;
-	} s_util;
-	union {
-		guint16 s[2];
-		guint32	l;
-	} l_util;
-
-	for (; veclen != 0; vec++, veclen--) {
-		if (vec->len == 0)
-			continue;
-		w = (const guint16 *)(const void *)vec->ptr;
-		if (mlen == -1) {
-			/*
-			 * The first byte of this chunk is the continuation
-			 * of a word spanning between this chunk and the
-			 * last chunk.
-			 *
-			 * s_util.c[0] is already saved when scanning previous
-			 * chunk.
-			 */
-			s_util.c[1] = *(const guint8 *)w;
-			sum += s_util.s;
-			w = (const guint16 *)(const void *)((const guint8 *)w + 1);
-			mlen = vec->len - 1;
-		} else
-			mlen = vec->len;
+	guint64 sum = 0;
+	guint32 w32;
+	guint16 w16;
+	guint8 last[2];
+
+#ifdef WS_HAVE_SSE2
+	if (len >= 64) {
+		const __m128i zero = _mm_setzero_si128();
+		__m128i acc0, acc1, acc2, acc3, v;
+		guint64 lanes[2];
+		int block;
+
 		/*
-		 * Force to even boundary.
+		 * Widen each 16-bit word to 32 bits and add it into one of
+		 * sixteen 32-bit lanes, in four independent accumulators.
+		 * Each lane gets two words per 64-byte block and can take
+		 * 65537 words before it could overflow, so empty the lanes
+		 * every 32768 blocks.
 		 */
-		if ((1 & (gintptr)w) && (mlen > 0)) {
-			REDUCE;
-			sum <<= 8;
-			s_util.c[0] = *(const guint8 *)w;
-			w = (const guint16 *)(const void *)((const guint8 *)w + 1);
-			mlen--;
-			byte_swapped = 1;
+		while (len >= 64) {
+			acc0 = acc1 = acc2 = acc3 = zero;
+			for (block = 0; block < 32768 && len >= 64; block++) {
+				v = _mm_loadu_si128((const __m128i *)(const void *)p);
+				acc0 = _mm_add_epi32(acc0, _mm_unpacklo_epi16(v, zero));
+				acc1 = _mm_add_epi32(acc1, _mm_unpackhi_epi16(v, zero));
+				v = _mm_loadu_si128((const __m128i *)(const void *)(p + 16));
+				acc2 = _mm_add_epi32(acc2, _mm_unpacklo_epi16(v, zero));
+				acc3 = _mm_add_epi32(acc3, _mm_unpackhi_epi16(v, zero));
+				v = _mm_loadu_si128((const __m128i *)(const void *)(p + 32));
+				acc0 = _mm_add_epi32(acc0, _mm_unpacklo_epi16(v, zero));
+				acc1 = _mm_add_epi32(acc1, _mm_unpackhi_epi16(v, zero));
+				v = _mm_loadu_si128((const __m128i *)(const void *)(p + 48));
+				acc2 = _mm_add_epi32(acc2, _mm_unpacklo_epi16(v, zero));
+				acc3 = _mm_add_epi32(acc3, _mm_unpackhi_epi16(v, zero));
+				p += 64;
+				len -= 64;
+			}
+			/* Add pairs of lanes as 64-bit values so nothing is lost. */
+			acc0 = _mm_add_epi64(_mm_unpacklo_epi32(acc0, zero), _mm_unpackhi_epi32(acc0, zero));
+			acc1 = _mm_add_epi64(_mm_unpacklo_epi32(acc1, zero), _mm_unpackhi_epi32(acc1, zero));
+			acc2 = _mm_add_epi64(_mm_unpacklo_epi32(acc2, zero), _mm_unpackhi_epi32(acc2, zero));
+			acc3 = _mm_add_epi64(_mm_unpacklo_epi32(acc3, zero), _mm_unpackhi_epi32(acc3, zero));
+			acc0 = _mm_add_epi64(_mm_add_epi64(acc0, acc1), _mm_add_epi64(acc2, acc3));
+			_mm_storeu_si128((__m128i *)(void *)lanes, acc0);
+			sum += lanes[0] + lanes[1];
 		}
+	}
+#endif
+
+	/*
+	 * Unroll the loop to make overhead from
+	 * branches &c small.
+	 */
+	while (len >= 32) {
+		memcpy(&w32, p, 4); sum += w32;
+		memcpy(&w32, p + 4, 4); sum += w32;
+		memcpy(&w32, p + 8, 4); sum += w32;
+		memcpy(&w32, p + 12, 4); sum += w32;
+		memcpy(&w32, p + 16, 4); sum += w32;
+		memcpy(&w32, p + 20, 4); sum += w32;
+		memcpy(&w32, p + 24, 4); sum += w32;
+		memcpy(&w32, p + 28, 4); sum += w32;
+		p += 32;
+		len -= 32;
+	}
+	while (len >= 4) {
+		memcpy(&w32, p, 4);
+		sum += w32;
+		p += 4;
+		len -= 4;
+	}
+	if (len >= 2) {
+		memcpy(&w16, p, 2);
+		sum += w16;
+		p += 2;
+		len -= 2;
+	}
+	if (len == 1) {
+		/* Follow the standard (the odd byte may be shifted left
+		   by 8 bits or not as determined by endian-ness of the
+		   machine) */
+		last[0] = *p;
+		last[1] = 0;
+		memcpy(&w16, last, 2);
+		sum += w16;
+	}
+
+	return in_cksum_fold(sum);
+}
+
+void
+in_cksum_init(in_cksum_ctx_t *ctx)
+{
+	ctx->sum = 0;
+	ctx->odd = FALSE;
+}
+
+void
+in_cksum_update(in_cksum_ctx_t *ctx, const guint8 *ptr, int len)
+{
+	guint32 sum;
+
+	if (len <= 0)
+		return;
+
+	sum = in_cksum_sum(ptr, len);
+	if (ctx->odd) {
 		/*
-		 * Unroll the loop to make overhead from
-		 * branches &c small.
+		 * These bytes start in the middle of a 16-bit word, so
+		 * each of them belongs in the other half of its word;
+		 * swapping the bytes of their sum does that.
 		 */
-		while ((mlen -= 32) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			sum += w[4]; sum += w[5]; sum += w[6]; sum += w[7];
-			sum += w[8]; sum += w[9]; sum += w[10]; sum += w[11];
-			sum += w[12]; sum += w[13]; sum += w[14]; sum += w[15];
-			w += 16;
-		}
-		mlen += 32;
-		while ((mlen -= 8) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			w += 4;
-		}
-		mlen += 8;
-		if (mlen == 0 && byte_swapped == 0)
-			continue;
-		REDUCE;
-		while ((mlen -= 2) >= 0) {
-			sum += *w++;
-		}
-		if (byte_swapped) {
-			REDUCE;
-			sum <<= 8;
-			byte_swapped = 0;
-			if (mlen == -1) {
-				s_util.c[1] = *(const guint8 *)w;
-				sum += s_util.s;
-				mlen = 0;
-			} else
-				mlen = -1;
-		} else if (mlen == -1)
-			s_util.c[0] = *(const guint8 *)w;
+		sum = ((sum & 0xFF) << 8) | (sum >> 8);
 	}
-	if (mlen == -1) {
-		/* The last mbuf has odd # of bytes. Follow the
-		   standard (the odd byte may be shifted left by 8 bits
-		   or not as determined by endian-ness of the machine) */
-		s_util.c[1] = 0;
-		sum += s_util.s;
+	ctx->sum = in_cksum_fold((guint64)ctx->sum + sum);
+	if (len & 1)
+		ctx->odd = !ctx->odd;
+}
+
+void
+in_cksum_update_tvb(in_cksum_ctx_t *ctx, tvbuff_t *tvb, int offset, int len)
+{
+	int chunk;
+
+	/* A piece at a time, so that a composite tvbuff, e.g. a reassembled
+	 * PDU, isn't copied into one buffer just to be summed. */
+	while (len > 0) {
+		chunk = (int)tvb_contiguous_length(tvb, offset, len);
+		in_cksum_update(ctx, tvb_get_ptr(tvb, offset, chunk), chunk);
+		offset += chunk;
+		len -= chunk;
 	}
-	REDUCE;
-	return (~sum & 0xffff);
+}
+
+guint16
+in_cksum_final(const in_cksum_ctx_t *ctx)
+{
+	return (guint16)(~ctx->sum & 0xffff);
+}
+
+int
+in_cksum(const vec_t *vec, int veclen)
+{
+	in_cksum_ctx_t ctx;
+
+	in_cksum_init(&ctx);
+	for (; veclen != 0; vec++, veclen--)
+		in_cksum_update(&ctx, vec->ptr, vec->len);
+	return in_cksum_final(&ctx);
 }
 
 guint16
@@ -35,6 +35,26 @@ WS_DLL_PUBLIC guint16 ip_checksum_tvb(tvbuff_t *tvb, int offset, int len);
 
 WS_DLL_PUBLIC int in_cksum(const vec_t *vec, int veclen);
 
+/*
+ * Incremental computation of the same checksum, for data that isn't in
+ * one place, e.g. the segments of a reassembled PDU, without copying it
+ * together or building a vec_t array up front.  Pieces may have any
+ * length, odd or even; in_cksum_final() returns what in_cksum() would
+ * have returned for all of them.
+ */
+typedef struct {
+	guint32	sum;	/* one's complement sum so far, not complemented */
+	gboolean odd;	/* TRUE if an odd number of bytes has been added */
+} in_cksum_ctx_t;
+
+WS_DLL_PUBLIC void in_cksum_init(in_cksum_ctx_t *ctx);
+
+WS_DLL_PUBLIC void in_cksum_update(in_cksum_ctx_t *ctx, const guint8 *ptr, int len);
+
+WS_DLL_PUBLIC void in_cksum_update_tvb(in_cksum_ctx_t *ctx, tvbuff_t *tvb, int offset, int len);
+
+WS_DLL_PUBLIC guint16 in_cksum_final(const in_cksum_ctx_t *ctx);
+
 guint16 in_cksum_shouldbe(guint16 sum, guint16 computed_sum);
 
 #endif /* __IN_CKSUM_H__ */
@@ -0,0 +1,257 @@
+/* in_cksum_test.c
+ * Standalone program to test the Internet checksum routines.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <epan/tvbuff.h>
+#include <epan/in_cksum.h>
+
+#define DATA_LENGTH 2000
+
+static gboolean failed = FALSE;
+
+/*
+ * The 16-bit-at-a-time routine in_cksum() used to be: the one's complement
+ * of the one's complement sum of the host-byte-order 16-bit words of the
+ * data, an odd final byte padded with a zero byte.
+ */
+static guint16
+reference_cksum(const guint8 *p, guint len)
+{
+	guint32 sum = 0;
+	guint16 w16;
+	guint8 last[2];
+
+	for (; len >= 2; p += 2, len -= 2) {
+		memcpy(&w16, p, 2);
+		sum += w16;
+		sum = (sum & 0xFFFF) + (sum >> 16);
+	}
+	if (len == 1) {
+		last[0] = *p;
+		last[1] = 0;
+		memcpy(&w16, last, 2);
+		sum += w16;
+		sum = (sum & 0xFFFF) + (sum >> 16);
+	}
+	return (guint16)(~sum & 0xFFFF);
+}
+
+static void
+check(const char *what, guint offset, guint len, guint16 cksum, guint16 expected)
+{
+	if (cksum != expected) {
+		printf("Failed: %s offset %u length %u is 0x%04x, expected 0x%04x\n",
+		    what, offset, len, cksum, expected);
+		failed = TRUE;
+	}
+}
+
+/* An IPv4 header with a correct checksum sums to zero, and the checksum
+ * computed with the field zeroed is what goes into the field. */
+static void
+check_header(void)
+{
+	static const guint8 header[20] = {
+		0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40, 0x00, 0x40, 0x11,
+		0xb8, 0x61, 0xc0, 0xa8, 0x00, 0x01, 0xc0, 0xa8, 0x00, 0xc7
+	};
+	guint8 zeroed[20];
+	guint16 cksum;
+
+	check("IPv4 header", 0, 20, ip_checksum(header, 20), 0);
+
+	memcpy(zeroed, header, 20);
+	zeroed[10] = zeroed[11] = 0;
+	cksum = ip_checksum(zeroed, 20);
+	if (memcmp(&cksum, header + 10, 2) != 0) {
+		printf("Failed: IPv4 header checksum field is wrong\n");
+		failed = TRUE;
+	}
+}
+
+/* Random ranges of random data, starting at any alignment, with lengths on
+ * both sides of the 64-byte blocks the wide loops work in. */
+static void
+check_ranges(GRand *rand, const guint8 *data)
+{
+	guint i, offset, len;
+	guint16 expected;
+	in_cksum_ctx_t ctx;
+	tvbuff_t *tvb;
+
+	for (i = 0; i < 20000; i++) {
+		offset = (guint)g_rand_int_range(rand, 0, 16);
+		len = (guint)g_rand_int_range(rand, 0, 300);
+		expected = reference_cksum(data + offset, len);
+
+		check("ip_checksum", offset, len,
+		    ip_checksum(data + offset, len), expected);
+
+		in_cksum_init(&ctx);
+		in_cksum_update(&ctx, data + offset, len);
+		check("in_cksum_update", offset, len, in_cksum_final(&ctx), expected);
+
+		tvb = tvb_new_real_data(data, offset + len, offset + len);
+		in_cksum_init(&ctx);
+		in_cksum_update_tvb(&ctx, tvb, offset, len);
+		check("in_cksum_update_tvb", offset, len, in_cksum_final(&ctx), expected);
+		tvb_free(tvb);
+	}
+}
+
+/* The same data split into two or three vec_t entries / updates, at every
+ * split point, so that pieces start and end on odd and even bytes. */
+static void
+check_splits(const guint8 *data)
+{
+	static const guint lengths[] = { 1, 2, 3, 63, 64, 65, 127, 128, 129, 257 };
+	guint i, offset, len, split1, split2;
+	guint16 expected;
+	vec_t vec[3];
+	in_cksum_ctx_t ctx;
+
+	for (i = 0; i < G_N_ELEMENTS(lengths); i++) {
+		len = lengths[i];
+		for (offset = 0; offset < 4; offset++) {
+			expected = reference_cksum(data + offset, len);
+			for (split1 = 0; split1 <= len; split1++) {
+				SET_CKSUM_VEC_PTR(vec[0], data + offset, split1);
+				SET_CKSUM_VEC_PTR(vec[1], data + offset + split1, len - split1);
+				check("in_cksum (2 vecs)", offset, len, in_cksum(vec, 2), expected);
+
+				/* A third piece of a few bytes after the first split. */
+				for (split2 = split1; split2 <= len && split2 <= split1 + 5; split2++) {
+					SET_CKSUM_VEC_PTR(vec[0], data + offset, split1);
+					SET_CKSUM_VEC_PTR(vec[1], data + offset + split1, split2 - split1);
+					SET_CKSUM_VEC_PTR(vec[2], data + offset + split2, len - split2);
+					check("in_cksum (3 vecs)", offset, len, in_cksum(vec, 3), expected);
+
+					in_cksum_init(&ctx);
+					in_cksum_update(&ctx, data + offset, split1);
+					in_cksum_update(&ctx, data + offset + split1, split2 - split1);
+					in_cksum_update(&ctx, data + offset + split2, len - split2);
+					check("in_cksum_update (3 pieces)", offset, len, in_cksum_final(&ctx), expected);
+				}
+			}
+		}
+	}
+}
+
+/* All-ones data makes every partial sum wrap, and buffers over 2MB make
+ * the SSE2 loop empty its lanes. */
+static void
+check_large(void)
+{
+	static const guint lengths[] = { 64, 1500, 65536 + 1, 4 * 1024 * 1024 + 3 };
+	guint i, len;
+	guint8 *buf;
+	vec_t vec[2];
+
+	for (i = 0; i < G_N_ELEMENTS(lengths); i++) {
+		len = lengths[i];
+		buf = (guint8 *)g_malloc(len);
+
+		memset(buf, 0xFF, len);
+		check("ip_checksum (all ones)", 0, len, ip_checksum(buf, len), reference_cksum(buf, len));
+		SET_CKSUM_VEC_PTR(vec[0], buf, len / 3);
+		SET_CKSUM_VEC_PTR(vec[1], buf + len / 3, len - len / 3);
+		check("in_cksum (all ones)", 0, len, in_cksum(vec, 2), reference_cksum(buf, len));
+
+		memset(buf, 0, len);
+		check("ip_checksum (all zeros)", 0, len, ip_checksum(buf, len), reference_cksum(buf, len));
+
+		g_free(buf);
+	}
+}
+
+/* A reassembled PDU: pieces of odd and even lengths in a composite tvbuff,
+ * summed directly and through subsets, without being copied together. */
+static void
+check_composite(GRand *rand, const guint8 *data)
+{
+	tvbuff_t *tvb, *member, *subset;
+	guint i, offset, len, member_len;
+	in_cksum_ctx_t ctx;
+	guint16 expected;
+
+	tvb = tvb_new_owning_composite();
+	for (offset = 0; offset < DATA_LENGTH; offset += member_len) {
+		member_len = MIN((guint)g_rand_int_range(rand, 1, 38), DATA_LENGTH - offset);
+		member = tvb_new_real_data(data + offset, member_len, member_len);
+		tvb_composite_append(tvb, member);
+	}
+	tvb_composite_finalize(tvb);
+
+	for (i = 0; i < 2000; i++) {
+		offset = (guint)g_rand_int_range(rand, 0, DATA_LENGTH);
+		len = (guint)g_rand_int_range(rand, 0, DATA_LENGTH - offset + 1);
+		expected = reference_cksum(data + offset, len);
+
+		in_cksum_init(&ctx);
+		in_cksum_update_tvb(&ctx, tvb, offset, len);
+		check("in_cksum_update_tvb (composite)", offset, len, in_cksum_final(&ctx), expected);
+
+		subset = tvb_new_subset_length(tvb, offset, len);
+		in_cksum_init(&ctx);
+		in_cksum_update_tvb(&ctx, subset, 0, len);
+		check("in_cksum_update_tvb (subset)", offset, len, in_cksum_final(&ctx), expected);
+	}
+
+	if (tvb_contiguous_length(tvb, 0, DATA_LENGTH) == DATA_LENGTH) {
+		printf("Failed: summing a composite tvbuff copied it into one buffer\n");
+		failed = TRUE;
+	}
+
+	tvb_free(tvb);	/* frees the members and subsets as well */
+}
+
+int
+main(void)
+{
+	GRand *rand;
+	guint8 *data;
+	guint i;
+
+	rand = g_rand_new_with_seed(0x1071);
+	data = (guint8 *)g_malloc(DATA_LENGTH);
+	for (i = 0; i < DATA_LENGTH; i++)
+		data[i] = (guint8)g_rand_int(rand);
+
+	check_header();
+	check_ranges(rand, data);
+	check_splits(data);
+	check_composite(rand, data);
+	check_large();
+	if (!failed)
+		printf("Passed Internet checksum tests\n");
+
+	g_free(data);
+	g_rand_free(rand);
+	exit(failed ? 1 : 0);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -79,6 +79,12 @@ struct data_source {
  *
  * "protocol" is the protocol associated with the dissector table. Used
  * for determining dependencies.
+ *
+ * "direct" is, for FT_UINT8 and FT_UINT16 tables, an array of
+ * "direct_size" entries indexed by pattern that mirrors "hash_table".
+ * It is built once the table has served DIRECT_LOOKUP_THRESHOLD lookups
+ * and thrown away whenever an entry is added to or removed from the
+ * hash table; "direct_lookups" counts the lookups since then.
  */
 struct dissector_table {
 	GHashTable	*hash_table;
@@ -89,8 +95,19 @@ struct dissector_table {
 	protocol_t	*protocol;
 	GHashFunc	hash_func;
 	gboolean	supports_decode_as;
+	dtbl_entry_t	**direct;
+	guint32		direct_size;
+	guint		direct_lookups;
 };
 
+/*
+ * Number of lookups a small uint dissector table has to serve, with no
+ * entries added or removed, before we build its direct-indexed array.
+ * This keeps the 16-bit tables that are only consulted during
+ * registration, or by the odd packet, from costing 512KB each.
+ */
+#define DIRECT_LOOKUP_THRESHOLD	1024
+
 /*
  * Dissector tables. const char * -> dissector_table *
  */
@@ -161,6 +178,9 @@ struct heur_dissector_list {
 
 static GHashTable *heur_dissector_lists = NULL;
 
+/* TRUE if dissector_try_heuristic() should time heuristic dissectors */
+static gboolean heur_dissector_profiling = FALSE;
+
 /* Name hashtables for fast detection of duplicate names */
 static GHashTable* heuristic_short_names  = NULL;
 
@@ -189,6 +209,7 @@ destroy_dissector_table(void *data)
 	struct dissector_table *table = (struct dissector_table *)data;
 
 	g_hash_table_destroy(table->hash_table);
+	g_free(table->direct);
 	g_slist_free(table->dissector_handles);
 	g_slice_free(struct dissector_table, data);
 }
@@ -939,10 +960,51 @@ find_dissector_table(const char *name)
 	return dissector_table;
 }
 
+/*
+ * Discard the direct-indexed array of a uint dissector table; this must
+ * be done whenever an entry is added to or removed from its hash table.
+ * Changing the handle of an existing entry doesn't require it, as the
+ * array points to the entries themselves.
+ */
+static void
+dissector_table_invalidate_direct(dissector_table_t sub_dissectors)
+{
+	g_free(sub_dissectors->direct);
+	sub_dissectors->direct = NULL;
+	sub_dissectors->direct_lookups = 0;
+}
+
+static void
+dissector_table_build_direct(dissector_table_t sub_dissectors)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	guint32 pattern;
+
+	sub_dissectors->direct = g_new0(dtbl_entry_t *, sub_dissectors->direct_size);
+	g_hash_table_iter_init(&iter, sub_dissectors->hash_table);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		/*
+		 * Patterns that don't fit the table's type are left
+		 * to the hash table.
+		 */
+		pattern = GPOINTER_TO_UINT(key);
+		if (pattern < sub_dissectors->direct_size)
+			sub_dissectors->direct[pattern] = (dtbl_entry_t *)value;
+	}
+}
+
 /* Find an entry in a uint dissector table. */
 static dtbl_entry_t *
 find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
 {
+	/*
+	 * Fast path: the table has a direct-indexed array covering
+	 * this pattern.
+	 */
+	if (sub_dissectors->direct != NULL && pattern < sub_dissectors->direct_size)
+		return sub_dissectors->direct[pattern];
+
 	switch (sub_dissectors->type) {
 
 	case FT_UINT8:
@@ -965,6 +1027,17 @@ find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
 		g_assert_not_reached();
 	}
 
+	/*
+	 * If this is a small table that's being used a lot, build its
+	 * direct-indexed array.
+	 */
+	if (sub_dissectors->direct == NULL && sub_dissectors->direct_size != 0 &&
+	    ++sub_dissectors->direct_lookups >= DIRECT_LOOKUP_THRESHOLD) {
+		dissector_table_build_direct(sub_dissectors);
+		if (pattern < sub_dissectors->direct_size)
+			return sub_dissectors->direct[pattern];
+	}
+
 	/*
 	 * Find the entry.
 	 */
@@ -1051,6 +1124,7 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	dissector_table_invalidate_direct(sub_dissectors);
 
 	/*
 	 * Now, if this table supports "Decode As", add this handle
@@ -1212,6 +1286,7 @@ dissector_delete_uint(const char *name, const guint32 pattern,
 		 */
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		dissector_table_invalidate_direct(sub_dissectors);
 	}
 }
 
@@ -1252,7 +1327,8 @@ void dissector_delete_all(const char *name, dissector_handle_t handle)
 	dissector_table_t sub_dissectors = find_dissector_table(name);
 	g_assert (sub_dissectors);
 
-	g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle);
+	if (g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle))
+		dissector_table_invalidate_direct(sub_dissectors);
 }
 
 static void
@@ -1261,7 +1337,8 @@ dissector_delete_from_table(gpointer key _U_, gpointer value, gpointer user_data
 	dissector_table_t sub_dissectors = (dissector_table_t) value;
 	g_assert (sub_dissectors);
 
-	g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data);
+	if (g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data))
+		dissector_table_invalidate_direct(sub_dissectors);
 	sub_dissectors->dissector_handles = g_slist_remove(sub_dissectors->dissector_handles, user_data);
 }
 
@@ -1307,6 +1384,7 @@ dissector_change_uint(const char *name, const guint32 pattern, dissector_handle_
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	dissector_table_invalidate_direct(sub_dissectors);
 }
 
 /* Reset an entry in a uint dissector table to its initial value. */
@@ -1335,6 +1413,7 @@ dissector_reset_uint(const char *name, const guint32 pattern)
 	} else {
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		dissector_table_invalidate_direct(sub_dissectors);
 	}
 }
 
@@ -2402,10 +2481,19 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
 	sub_dissectors = g_slice_new(struct dissector_table);
+	sub_dissectors->direct = NULL;
+	sub_dissectors->direct_size = 0;
+	sub_dissectors->direct_lookups = 0;
 	switch (type) {
 
 	case FT_UINT8:
 	case FT_UINT16:
+		/*
+		 * Small enough to be looked up with a direct-indexed
+		 * array once the table is in heavy use.
+		 */
+		sub_dissectors->direct_size = (type == FT_UINT8) ? 0x100 : 0x10000;
+		/* FALL THROUGH */
 	case FT_UINT24:
 	case FT_UINT32:
 		/*
@@ -2473,6 +2561,9 @@ dissector_table_t register_custom_dissector_table(const char *name,
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
 	sub_dissectors = g_slice_new(struct dissector_table);
+	sub_dissectors->direct = NULL;
+	sub_dissectors->direct_size = 0;
+	sub_dissectors->direct_lookups = 0;
 	sub_dissectors->hash_func = hash_func;
 	sub_dissectors->hash_table = g_hash_table_new_full(hash_func,
 							       key_equal_func,
@@ -2627,6 +2718,9 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 	hdtbl_entry->short_name = g_strdup(short_name);
 	hdtbl_entry->list_name = g_strdup(name);
 	hdtbl_entry->enabled   = (enable == HEURISTIC_ENABLE);
+	hdtbl_entry->calls     = 0;
+	hdtbl_entry->accepts   = 0;
+	hdtbl_entry->time_us   = 0;
 
 	/* do the table insertion */
 	g_hash_table_insert(heuristic_short_names, (gpointer)hdtbl_entry->short_name, hdtbl_entry);
@@ -2688,12 +2782,13 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	gboolean           status;
 	const char        *saved_curr_proto;
 	const char        *saved_heur_list_name;
-	GSList            *entry;
+	GSList            *entry, *prev_entry;
 	guint16            saved_can_desegment;
 	guint              saved_layers_len = 0;
 	heur_dtbl_entry_t *hdtbl_entry;
 	int                proto_id;
 	int                len;
+	gint64             start_time = 0;
 	int                saved_tree_count = tree ? tree->tree_data->count : 0;
 
 	/* can_desegment is set to 2 by anyone which offers this api/service.
@@ -2716,8 +2811,8 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	saved_layers_len = wmem_list_count(pinfo->layers);
 	*heur_dtbl_entry = NULL;
 
-	for (entry = sub_dissectors->dissectors; entry != NULL;
-	    entry = g_slist_next(entry)) {
+	for (prev_entry = NULL, entry = sub_dissectors->dissectors; entry != NULL;
+	    prev_entry = entry, entry = g_slist_next(entry)) {
 		/* XXX - why set this now and above? */
 		pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
 		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
@@ -2747,7 +2842,12 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 
 		pinfo->heur_list_name = hdtbl_entry->list_name;
 
+		hdtbl_entry->calls++;
+		if (heur_dissector_profiling)
+			start_time = g_get_monotonic_time();
 		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+		if (heur_dissector_profiling)
+			hdtbl_entry->time_us += g_get_monotonic_time() - start_time;
 		if (hdtbl_entry->protocol != NULL &&
 			(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
 			/*
@@ -2761,6 +2861,25 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			}
 		}
 		if (len) {
+			hdtbl_entry->accepts++;
+			/*
+			 * If this heuristic has now accepted more packets
+			 * than the one in front of it, swap them, so that
+			 * over time the list ends up ordered by the number
+			 * of packets each heuristic accepts.
+			 *
+			 * The dissector may have called heuristics of this
+			 * same list, which may already have reordered it;
+			 * in that case leave it alone.
+			 */
+			if (prefs.adaptive_heuristic_order && prev_entry != NULL &&
+			    entry->data == hdtbl_entry &&
+			    ((heur_dtbl_entry_t *)prev_entry->data)->accepts < hdtbl_entry->accepts) {
+				gpointer tmp = entry->data;
+
+				entry->data = prev_entry->data;
+				prev_entry->data = tmp;
+			}
 			*heur_dtbl_entry = hdtbl_entry;
 			status = TRUE;
 			break;
@@ -2773,6 +2892,38 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	return status;
 }
 
+void
+heur_dissector_set_profiling(gboolean enable)
+{
+	heur_dissector_profiling = enable;
+}
+
+static void
+heur_dissector_reset_stats_func(gpointer data, gpointer user_data _U_)
+{
+	heur_dtbl_entry_t *hdtbl_entry = (heur_dtbl_entry_t *)data;
+
+	hdtbl_entry->calls   = 0;
+	hdtbl_entry->accepts = 0;
+	hdtbl_entry->time_us = 0;
+}
+
+static void
+heur_dissector_reset_stats_list_func(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	heur_dissector_list_t sub_dissectors = (heur_dissector_list_t)value;
+
+	g_slist_foreach(sub_dissectors->dissectors,
+			heur_dissector_reset_stats_func, NULL);
+}
+
+void
+heur_dissector_reset_stats(void)
+{
+	g_hash_table_foreach(heur_dissector_lists,
+			     heur_dissector_reset_stats_list_func, NULL);
+}
+
 typedef struct heur_dissector_foreach_info {
 	gpointer      caller_data;
 	DATFunc_heur  caller_func;
@@ -433,6 +433,9 @@ typedef struct heur_dtbl_entry {
 	const gchar *display_name;     /* the string used to present heuristic to user */
 	gchar *short_name;     /* string used for "internal" use to uniquely identify heuristic */
 	gboolean enabled;
+	guint64 calls;        /* number of times dissector_try_heuristic() tried this entry */
+	guint64 accepts;      /* number of times this entry accepted the packet */
+	guint64 time_us;      /* microseconds spent in the dissector, if profiling is enabled */
 } heur_dtbl_entry_t;
 
 /** A protocol uses this function to register a heuristic sub-dissector list.
@@ -488,6 +491,22 @@ WS_DLL_PUBLIC gboolean has_heur_dissector_list(const gchar *name);
 WS_DLL_PUBLIC gboolean dissector_try_heuristic(heur_dissector_list_t sub_dissectors,
     tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, heur_dtbl_entry_t **hdtbl_entry, void *data);
 
+/** Enable or disable timing of heuristic dissectors.
+ *
+ * The "calls" and "accepts" counters of each heuristic dissector entry are
+ * always maintained; while profiling is enabled, the time spent in each
+ * call is also added to its "time_us" counter.  That time is measured with
+ * a microsecond clock, so it is only meaningful summed over many calls.
+ *
+ * @param enable TRUE to start timing heuristic dissectors, FALSE to stop
+ */
+WS_DLL_PUBLIC void heur_dissector_set_profiling(gboolean enable);
+
+/** Reset the "calls", "accepts" and "time_us" counters of all heuristic
+ * dissector entries to zero.
+ */
+WS_DLL_PUBLIC void heur_dissector_reset_stats(void);
+
 /** Find a heuristic dissector table by table name.
  *
  * @param name name of the dissector table
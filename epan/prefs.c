@@ -3647,6 +3647,13 @@ prefs_register_modules(void)
                                    "Currently only ICMP and ICMPv6 use this preference to add VLAN ID to conversation tracking",
                                    &prefs.strict_conversation_tracking_heuristics);
 
+    prefs_register_bool_preference(protocols_module, "adaptive_heuristic_order",
+                                   "Try successful heuristic dissectors first",
+                                   "Reorder each list of heuristic dissectors as packets are dissected, so that the heuristics that "
+                                   "accept the most packets are tried first. This is faster on traffic dominated by a few heuristic "
+                                   "protocols, but when more than one heuristic could accept a packet, which one does may change.",
+                                   &prefs.adaptive_heuristic_order);
+
     /* Obsolete preferences
      * These "modules" were reorganized/renamed to correspond to their GUI
      * configuration screen within the preferences dialog
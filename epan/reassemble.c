@@ -532,6 +532,91 @@ reassembly_table_destroy(reassembly_table *table)
 	}
 }
 
+typedef struct {
+	guint32 last_frame_before;
+	guint count;
+	GPtrArray *allocated_fragments;
+} reassembly_expire_data_t;
+
+/*
+ * For a fragment hash table entry, free the associated fragments if
+ * the last of them was added before the expiry frame.  A reassembly
+ * that hasn't got any fragments yet is kept.
+ */
+static gboolean
+expire_fragments(gpointer key_arg, gpointer value, gpointer user_data)
+{
+	reassembly_expire_data_t *data = (reassembly_expire_data_t *)user_data;
+	fragment_head *fd_head = (fragment_head *)value;
+	fragment_item *fd;
+	guint32 last_frame = fd_head->frame;
+
+	for (fd = fd_head->next; fd != NULL; fd = fd->next) {
+		if (fd->frame > last_frame)
+			last_frame = fd->frame;
+	}
+	if (last_frame == 0 || last_frame >= data->last_frame_before)
+		return FALSE;
+
+	data->count++;
+	return free_all_fragments(key_arg, value, NULL);
+}
+
+/*
+ * For a reassembled-packet hash table entry, free the fragment data if
+ * the packet was reassembled before the expiry frame.  All the entries
+ * for a reassembled packet share its fd_head, so they all go together.
+ */
+static gboolean
+expire_reassembled_fragments(gpointer key_arg, gpointer value,
+			     gpointer user_data)
+{
+	reassembly_expire_data_t *data = (reassembly_expire_data_t *)user_data;
+	fragment_head *fd_head = (fragment_head *)value;
+
+	if (fd_head->reassembled_in >= data->last_frame_before)
+		return FALSE;
+
+	if (fd_head->flags != FD_VISITED_FREE)
+		data->count++;
+	return free_all_reassembled_fragments(key_arg, value,
+					      data->allocated_fragments);
+}
+
+static void
+reassembly_table_expire(gpointer p, gpointer user_data)
+{
+	register_reassembly_table_t* reg_table = (register_reassembly_table_t*)p;
+	reassembly_table *table = reg_table->table;
+	reassembly_expire_data_t *data = (reassembly_expire_data_t *)user_data;
+
+	if (table->fragment_table != NULL)
+		g_hash_table_foreach_remove(table->fragment_table,
+					    expire_fragments, data);
+
+	if (table->reassembled_table != NULL) {
+		data->allocated_fragments = g_ptr_array_new();
+		g_hash_table_foreach_remove(table->reassembled_table,
+				expire_reassembled_fragments, data);
+
+		g_ptr_array_foreach(data->allocated_fragments, free_fragments, NULL);
+		g_ptr_array_free(data->allocated_fragments, TRUE);
+	}
+}
+
+guint
+reassembly_tables_expire(const guint32 last_frame_before)
+{
+	reassembly_expire_data_t data;
+
+	data.last_frame_before = last_frame_before;
+	data.count = 0;
+	data.allocated_fragments = NULL;
+	g_list_foreach(reassembly_table_list, reassembly_table_expire, &data);
+
+	return data.count;
+}
+
 /*
  * Look up an fd_head in the fragment table, optionally returning the key
  * for it.
@@ -1614,9 +1699,10 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 {
 	fragment_item *fd_i = NULL;
 	fragment_item *last_fd = NULL;
-	guint32  dfpos = 0, size = 0;
+	gboolean last_adopted = FALSE, adopted;
+	guint32  size = 0;
 	tvbuff_t *old_tvb_data = NULL;
-	guint8 *data;
+	tvbuff_t *member;
 
 	for(fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
 		if(!last_fd || last_fd->offset!=fd_i->offset){
@@ -1627,19 +1713,38 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 
 	/* store old data in case the fd_i->data pointers refer to it */
 	old_tvb_data=fd_head->tvb_data;
-	data = (guint8 *) g_malloc(size);
-	fd_head->tvb_data = tvb_new_real_data(data, size, size);
-	tvb_set_free_cb(fd_head->tvb_data, g_free);
 	fd_head->len = size;		/* record size for caller	*/
 
+	if (size == 0) {
+		fd_head->tvb_data = tvb_new_real_data(NULL, 0, 0);
+	} else {
+		/*
+		 * Build the reassembled PDU as a composite of the
+		 * fragments rather than copying them into a new buffer;
+		 * the composite takes over the fragments' own data.
+		 */
+		fd_head->tvb_data = tvb_new_owning_composite();
+	}
+
 	/* add all data fragments */
 	last_fd=NULL;
 	for (fd_i=fd_head->next; fd_i; fd_i=fd_i->next) {
+		adopted = FALSE;
 		if (fd_i->len) {
 			if(!last_fd || last_fd->offset != fd_i->offset) {
 				/* First fragment or in-sequence fragment */
-				memcpy(data+dfpos, tvb_get_ptr(fd_i->tvb_data, 0, fd_i->len), fd_i->len);
-				dfpos += fd_i->len;
+				if ((fd_i->flags & FD_SUBSET_TVB) ||
+				    tvb_captured_length(fd_i->tvb_data) != fd_i->len) {
+					/*
+					 * A subset refers to old_tvb_data,
+					 * which is about to go away; copy it.
+					 */
+					member = tvb_clone_offset_len(fd_i->tvb_data, 0, fd_i->len);
+				} else {
+					member = fd_i->tvb_data;
+					adopted = TRUE;
+				}
+				tvb_composite_append(fd_head->tvb_data, member);
 			} else {
 				/* duplicate/retransmission/overlap */
 				fd_i->flags    |= FD_OVERLAP;
@@ -1651,8 +1756,16 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 				}
 			}
 		}
+		/* The composite owns it now; don't free it below. */
+		if (last_adopted)
+			last_fd->tvb_data = NULL;
+		last_adopted = adopted;
 		last_fd=fd_i;
 	}
+	if (last_adopted)
+		last_fd->tvb_data = NULL;
+	if (size != 0)
+		tvb_composite_finalize(fd_head->tvb_data);
 
 	/* we have defragmented the pdu, now free all fragments*/
 	for (fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
@@ -175,6 +175,18 @@ reassembly_table_init(reassembly_table *table,
 WS_DLL_PUBLIC void
 reassembly_table_destroy(reassembly_table *table);
 
+/*
+ * Free the reassemblies, complete or not, in all registered reassembly
+ * tables whose fragments were all added before the given frame number.
+ *
+ * Like conversation_expire(), this is only safe for a single in-order pass
+ * over the packets, where no earlier frame is dissected again.
+ *
+ * Returns the number of reassemblies freed.
+ */
+WS_DLL_PUBLIC guint
+reassembly_tables_expire(const guint32 last_frame_before);
+
 /*
  * This function adds a new fragment to the reassembly table
  * If this is the first fragment seen for this datagram, a new entry
@@ -553,6 +553,178 @@ stats_tree_create_node_by_pname(stats_tree *st, const gchar *name,
     return stats_tree_create_node(st,name,stats_tree_parent_id_by_name(st,parent_name),datatype,with_children);
 }
 
+/* creates an empty tree of the same kind as st, to be fed by another worker */
+extern stats_tree*
+stats_tree_new_shard(const stats_tree *st)
+{
+    stats_tree *shard = stats_tree_new(st->cfg, NULL, st->filter);
+
+    if (st->cfg->init)
+        st->cfg->init(shard);
+
+    return shard;
+}
+
+/* finds the child of parent named name, without creating it */
+static stat_node*
+find_child_node(const stat_node *parent, const gchar *name)
+{
+    stat_node *child;
+
+    if (parent->hash)
+        return (stat_node *)g_hash_table_lookup(parent->hash, name);
+
+    for (child = parent->children; child; child = child->next) {
+        if (strcmp(child->name, name) == 0)
+            return child;
+    }
+
+    return NULL;
+}
+
+/*
+ * Folds the live burst window of src into the one of dst.  Both bucket
+ * lists are sorted by bucket_no, so this is a plain list merge; buckets
+ * that fall out of the window ending at the newest bucket are dropped
+ * like update_burst_calc() would have done.
+ */
+static void
+merge_burst_buckets(stat_node *dst, const stat_node *src)
+{
+    burst_bucket *d = dst->bh;
+    const burst_bucket *s;
+    burst_bucket *bn;
+    double burstwin;
+
+    if (src->max_burst > dst->max_burst ||
+        (src->max_burst == dst->max_burst && src->max_burst > 0 &&
+         src->burst_time < dst->burst_time)) {
+        dst->max_burst = src->max_burst;
+        dst->burst_time = src->burst_time;
+    }
+
+    if (!prefs.st_enable_burstinfo)
+        return;
+
+    for (s = src->bh; s; s = s->next) {
+        if (s->count == 0)
+            continue;
+
+        while (d->next && d->next->bucket_no <= s->bucket_no)
+            d = d->next;
+
+        if (d->bucket_no == s->bucket_no) {
+            d->count += s->count;
+            if (d->start_time > s->start_time)
+                d->start_time = s->start_time;
+            continue;
+        }
+
+        bn = (burst_bucket*)g_malloc0(sizeof(burst_bucket));
+        bn->count = s->count;
+        bn->bucket_no = s->bucket_no;
+        bn->start_time = s->start_time;
+        if (d->bucket_no < s->bucket_no) {
+            /* insert after d */
+            bn->prev = d;
+            bn->next = d->next;
+            if (d->next)
+                d->next->prev = bn;
+            else
+                dst->bt = bn;
+            d->next = bn;
+            d = bn;
+        } else {
+            /* only possible in front of the head */
+            bn->next = d;
+            d->prev = bn;
+            dst->bh = bn;
+            d = bn;
+        }
+    }
+
+    burstwin = prefs.st_burst_windowlen/prefs.st_burst_resolution;
+    while (dst->bh != dst->bt && dst->bt->bucket_no >= dst->bh->bucket_no+burstwin) {
+        bn = dst->bh;
+        dst->bh = bn->next;
+        dst->bh->prev = NULL;
+        g_free(bn);
+    }
+
+    dst->bcount = 0;
+    for (bn = dst->bh; bn; bn = bn->next)
+        dst->bcount += bn->count;
+
+    if (dst->bcount > dst->max_burst) {
+        dst->max_burst = dst->bcount;
+        dst->burst_time = dst->bh->start_time;
+    }
+}
+
+/* adds the counters of src and of all its children to dst */
+static void
+merge_stat_node(stats_tree *st, stat_node *dst, const stat_node *src)
+{
+    const stat_node *src_child;
+    stat_node *dst_child;
+
+    dst->counter += src->counter;
+    if (dst->datatype == src->datatype) {
+        switch (dst->datatype)
+        {
+        case STAT_DT_INT:
+            dst->total.int_total += src->total.int_total;
+            if (dst->minvalue.int_min > src->minvalue.int_min)
+                dst->minvalue.int_min = src->minvalue.int_min;
+            if (dst->maxvalue.int_max < src->maxvalue.int_max)
+                dst->maxvalue.int_max = src->maxvalue.int_max;
+            break;
+        case STAT_DT_FLOAT:
+            dst->total.float_total += src->total.float_total;
+            if (dst->minvalue.float_min > src->minvalue.float_min)
+                dst->minvalue.float_min = src->minvalue.float_min;
+            if (dst->maxvalue.float_max < src->maxvalue.float_max)
+                dst->maxvalue.float_max = src->maxvalue.float_max;
+            break;
+        }
+    }
+    dst->st_flags |= src->st_flags;
+
+    merge_burst_buckets(dst, src);
+
+    for (src_child = src->children; src_child; src_child = src_child->next) {
+        dst_child = find_child_node(dst, src_child->name);
+
+        if (dst_child == NULL) {
+            /* only registered parents can have children, so dst->id is valid */
+            dst_child = new_stat_node(st, src_child->name, dst->id, src_child->datatype,
+                                      src_child->hash != NULL, src_child->id >= 0);
+            if (src_child->rng) {
+                dst_child->rng = (range_pair_t *)g_memdup(src_child->rng, sizeof(range_pair_t));
+            }
+        }
+
+        merge_stat_node(st, dst_child, src_child);
+    }
+}
+
+/* adds the statistics gathered in the shard src to dst */
+extern void
+stats_tree_merge(stats_tree *dst, const stats_tree *src)
+{
+    g_assert(dst->cfg == src->cfg);
+
+    if (src->start >= 0.0) {
+        if (dst->start < 0.0 || src->start < dst->start)
+            dst->start = src->start;
+        if (src->now > dst->now)
+            dst->now = src->now;
+        dst->elapsed = dst->now - dst->start;
+    }
+
+    merge_stat_node(dst, &dst->root, &src->root);
+}
+
 /* Internal function to update the burst calculation data - add entry to bucket */
 static void
 update_burst_calc(stat_node *node, gint value)
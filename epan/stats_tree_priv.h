@@ -177,6 +177,15 @@ WS_DLL_PUBLIC void stats_tree_presentation(void (*registry_iterator)(gpointer,gp
 
 WS_DLL_PUBLIC stats_tree *stats_tree_new(stats_tree_cfg *cfg, tree_pres *pr, const char *filter);
 
+/** creates an empty tree with the same configuration and filter as st,
+    for a worker that taps a share of the packets on its own */
+WS_DLL_PUBLIC stats_tree *stats_tree_new_shard(const stats_tree *st);
+
+/** adds the counts, totals, min/max and burst data of the shard src to dst.
+    nodes are matched by name, so merging shards in a fixed order always
+    yields the same tree */
+WS_DLL_PUBLIC void stats_tree_merge(stats_tree *dst, const stats_tree *src);
+
 /** callback for taps */
 WS_DLL_PUBLIC tap_packet_status stats_tree_packet(void*, packet_info*, epan_dissect_t*, const void *);
 
@@ -0,0 +1,274 @@
+/* stats_tree_test.c
+ * Standalone program to test merging stats_tree shards.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <epan/packet_info.h>
+#include <epan/prefs.h>
+#include <epan/stats_tree.h>
+#include <epan/stats_tree_priv.h>
+
+#define NUM_RECORDS 4000
+#define NUM_LAST_BURST 300
+
+/* what the packet callback is handed instead of a tap's data */
+typedef struct {
+    double time;            /* ms */
+    const gchar *proto;
+    const gchar *host;
+    gint size;
+    gfloat rtt;
+} test_record;
+
+static test_record records[NUM_RECORDS];
+
+static gboolean failed = FALSE;
+
+static int st_node_packets = -1;
+static int st_node_sizes = -1;
+static int st_node_rtt = -1;
+static int st_node_hosts = -1;
+
+static void
+test_stats_tree_init(stats_tree *st)
+{
+    st_node_packets = stats_tree_create_node(st, "Packets", 0, STAT_DT_INT, TRUE);
+    st_node_sizes = stats_tree_create_range_node(st, "Sizes", 0,
+        "0-99", "100-499", "500-999", "1000-", NULL);
+    st_node_rtt = stats_tree_create_node(st, "RTT", 0, STAT_DT_FLOAT, TRUE);
+    st_node_hosts = stats_tree_create_pivot(st, "Hosts", 0);
+}
+
+static tap_packet_status
+test_stats_tree_packet(stats_tree *st, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *p)
+{
+    const test_record *rec = (const test_record *)p;
+    int proto_node;
+
+    tick_stat_node(st, "Packets", 0, FALSE);
+    proto_node = avg_stat_node_add_value_int(st, rec->proto, st_node_packets, TRUE, rec->size);
+    tick_stat_node(st, rec->size < 100 ? "short" : "long", proto_node, FALSE);
+    stats_tree_tick_range(st, "Sizes", 0, rec->size);
+    avg_stat_node_add_value_float(st, rec->proto, st_node_rtt, FALSE, rec->rtt);
+    stats_tree_tick_pivot(st, st_node_hosts, rec->host);
+
+    return TAP_PACKET_REDRAW;
+}
+
+static stats_tree_cfg test_cfg = {
+    (gchar *)"test",
+    (gchar *)"Test/Shards",
+    (gchar *)"test",
+    REGISTER_STAT_GROUP_GENERIC,
+    FALSE,
+    test_stats_tree_packet,
+    test_stats_tree_init,
+    NULL,
+    0,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    0
+};
+
+/*
+ * Bursts of traffic separated by quiet spells, ending with the busiest burst
+ * of all, all of it in the same millisecond. The merge only sees the shards'
+ * last burst windows, so a burst that straddles the boundary between two
+ * shards can be underestimated unless the second shard is still inside its
+ * first window; the records are split either at a spell longer than the
+ * burst window or at the start of that last burst. The RTTs are multiples of
+ * 1/8, so that their totals don't depend on the order they were added in.
+ */
+static void
+make_records(void)
+{
+    static const gchar *protos[] = { "tcp", "udp", "icmp" };
+    static const gchar *hosts[] = { "10.0.0.1", "10.0.0.2", "10.0.0.3", "10.0.0.4" };
+    guint32 seed = 12345;
+    double now = 0.0;
+    int i;
+
+    for (i = 0; i < NUM_RECORDS; i++) {
+        seed = seed * 1103515245 + 12345;
+
+        if (i == NUM_RECORDS / 2) {
+            now += 10 * prefs.st_burst_windowlen;
+        } else if (i < NUM_RECORDS - NUM_LAST_BURST) {
+            if (seed % 50 == 0)
+                now += (seed >> 8) % (3 * prefs.st_burst_windowlen);
+            else
+                now += (seed >> 16) % 4;
+        }
+
+        records[i].time = now;
+        /* a protocol and a host that only the second shard sees */
+        records[i].proto = (i > NUM_RECORDS / 2 && (seed >> 4) % 7 == 0) ? "sctp" : protos[(seed >> 12) % 3];
+        records[i].host = (i > NUM_RECORDS / 2 && (seed >> 6) % 9 == 0) ? "10.0.0.5" : hosts[(seed >> 20) % 4];
+        records[i].size = (seed >> 10) % 1500;
+        records[i].rtt = (gfloat)((seed >> 14) % 800) / 8;
+    }
+}
+
+static stats_tree *
+new_tree(void)
+{
+    stats_tree *st = stats_tree_new(&test_cfg, NULL, NULL);
+
+    test_cfg.init(st);
+    return st;
+}
+
+static void
+feed(stats_tree *st, int first, int last)
+{
+    packet_info pinfo;
+    int i;
+
+    memset(&pinfo, 0, sizeof(pinfo));
+    for (i = first; i < last; i++) {
+        pinfo.rel_ts.secs = (time_t)(records[i].time / 1000);
+        pinfo.rel_ts.nsecs = (int)((records[i].time - pinfo.rel_ts.secs * 1000.0) * 1000000);
+        stats_tree_packet(st, &pinfo, NULL, &records[i]);
+    }
+}
+
+#define CHECK(what, cond) \
+    if (!(cond)) { \
+        printf("Failed: %s: %s of %s differs\n", test, what, path); \
+        failed = TRUE; \
+    }
+
+static void
+check_node(const char *test, const char *path, const stat_node *expected, const stat_node *actual)
+{
+    const stat_node *e, *a;
+    gchar *child_path;
+
+    CHECK("name", strcmp(expected->name, actual->name) == 0);
+    CHECK("datatype", expected->datatype == actual->datatype);
+    CHECK("counter", expected->counter == actual->counter);
+    switch (expected->datatype)
+    {
+    case STAT_DT_INT:
+        CHECK("total", expected->total.int_total == actual->total.int_total);
+        CHECK("minimum", expected->minvalue.int_min == actual->minvalue.int_min);
+        CHECK("maximum", expected->maxvalue.int_max == actual->maxvalue.int_max);
+        break;
+    case STAT_DT_FLOAT:
+        CHECK("total", expected->total.float_total == actual->total.float_total);
+        CHECK("minimum", expected->minvalue.float_min == actual->minvalue.float_min);
+        CHECK("maximum", expected->maxvalue.float_max == actual->maxvalue.float_max);
+        break;
+    }
+    CHECK("burst count", expected->bcount == actual->bcount);
+    CHECK("max burst", expected->max_burst == actual->max_burst);
+    CHECK("burst time", expected->burst_time == actual->burst_time);
+    CHECK("flags", expected->st_flags == actual->st_flags);
+    CHECK("range", (expected->rng == NULL) == (actual->rng == NULL));
+    if (expected->rng && actual->rng) {
+        CHECK("range", expected->rng->floor == actual->rng->floor &&
+                       expected->rng->ceil == actual->rng->ceil);
+    }
+
+    for (e = expected->children, a = actual->children; e && a; e = e->next, a = a->next) {
+        child_path = g_strdup_printf("%s/%s", path, e->name);
+        check_node(test, child_path, e, a);
+        g_free(child_path);
+    }
+    CHECK("children", e == NULL && a == NULL);
+}
+
+static void
+check_tree(const char *test, const stats_tree *expected, const stats_tree *actual)
+{
+    const char *path = "tree";
+
+    CHECK("start", expected->start == actual->start);
+    CHECK("now", expected->now == actual->now);
+    CHECK("elapsed", expected->elapsed == actual->elapsed);
+    check_node(test, expected->root.name, &expected->root, &actual->root);
+}
+
+int
+main(void)
+{
+    stats_tree *whole, *shard1, *shard2, *merged;
+
+    prefs.st_enable_burstinfo = TRUE;
+    prefs.st_burst_resolution = 5;
+    prefs.st_burst_windowlen = 100;
+
+    make_records();
+
+    whole = new_tree();
+    feed(whole, 0, NUM_RECORDS);
+
+    shard1 = stats_tree_new_shard(whole);
+    shard2 = stats_tree_new_shard(whole);
+    feed(shard1, 0, NUM_RECORDS / 2);
+    feed(shard2, NUM_RECORDS / 2, NUM_RECORDS);
+
+    /* both shards merged into an empty one */
+    merged = stats_tree_new_shard(whole);
+    stats_tree_merge(merged, shard1);
+    stats_tree_merge(merged, shard2);
+    check_tree("merge into an empty tree", whole, merged);
+    stats_tree_free(merged);
+
+    /* the second shard merged into the first */
+    stats_tree_merge(shard1, shard2);
+    check_tree("merge into a shard", whole, shard1);
+
+    /* a shard that saw nothing changes nothing */
+    merged = stats_tree_new_shard(whole);
+    stats_tree_merge(shard1, merged);
+    check_tree("merge of an empty tree", whole, shard1);
+    stats_tree_free(merged);
+
+    stats_tree_free(shard2);
+    stats_tree_free(shard1);
+
+    /* the busiest burst split between two shards */
+    shard1 = stats_tree_new_shard(whole);
+    shard2 = stats_tree_new_shard(whole);
+    feed(shard1, 0, NUM_RECORDS - NUM_LAST_BURST);
+    feed(shard2, NUM_RECORDS - NUM_LAST_BURST, NUM_RECORDS);
+    stats_tree_merge(shard1, shard2);
+    check_tree("merge of a split burst", whole, shard1);
+
+    stats_tree_free(shard2);
+    stats_tree_free(shard1);
+    stats_tree_free(whole);
+
+    if (!failed)
+        printf("Passed stats_tree merge tests\n");
+
+    exit(failed ? 1 : 0);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
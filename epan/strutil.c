@@ -16,6 +16,8 @@
 #include "strutil.h"
 
 #include <wsutil/str_util.h>
+#include <wsutil/bits_ctz.h>
+#include <wsutil/ws_sse2.h>
 #include <epan/proto.h>
 
 #ifdef _WIN32
@@ -905,10 +907,46 @@ epan_memmem(const guint8 *haystack, guint haystack_len,
         return NULL;
     }
 
-    for (begin = haystack ; begin <= last_possible; ++begin) {
-        if (begin[0] == needle[0] &&
-                !memcmp(&begin[1], needle + 1,
-                    needle_len - 1)) {
+    begin = haystack;
+
+#ifdef WS_HAVE_SSE2
+    if (needle_len > 1) {
+        /*
+         * Check 16 candidate positions at a time, keeping only those
+         * where both the first and the last byte of the needle match,
+         * and compare the rest of the needle only there.
+         */
+        const __m128i first = _mm_set1_epi8((char)needle[0]);
+        const __m128i last = _mm_set1_epi8((char)needle[needle_len - 1]);
+        __m128i block_first, block_last;
+        unsigned int mask;
+        int bit;
+
+        while (last_possible - begin >= 15) {
+            block_first = _mm_loadu_si128((const __m128i *)(const void *)begin);
+            block_last = _mm_loadu_si128((const __m128i *)(const void *)(begin + needle_len - 1));
+            mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(
+                        _mm_cmpeq_epi8(block_first, first),
+                        _mm_cmpeq_epi8(block_last, last)));
+            while (mask) {
+                bit = ws_ctz(mask);
+                if (!memcmp(begin + bit + 1, needle + 1, needle_len - 2)) {
+                    return begin + bit;
+                }
+                mask &= mask - 1;
+            }
+            begin += 16;
+        }
+    }
+#endif
+
+    /* Let memchr() skip to the next candidate. */
+    for ( ; begin <= last_possible; ++begin) {
+        begin = (const guint8 *)memchr(begin, needle[0], last_possible - begin + 1);
+        if (begin == NULL) {
+            return NULL;
+        }
+        if (!memcmp(&begin[1], needle + 1, needle_len - 1)) {
             return begin;
         }
     }
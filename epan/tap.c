@@ -25,8 +25,8 @@
 #include <epan/packet_info.h>
 #include <epan/dfilter/dfilter.h>
 #include <epan/tap.h>
-
-static gboolean tapping_is_active=FALSE;
+#include <epan/epan-int.h>
+#include <epan/epan_dissect.h>
 
 typedef struct _tap_dissector_t {
 	struct _tap_dissector_t *next;
@@ -73,8 +73,16 @@ typedef struct _tap_packet_t {
 #define TAP_PACKET_IS_ERROR_PACKET	0x00000001	/* packet being queued is an error packet */
 
 #define TAP_PACKET_QUEUE_LEN 5000
-static tap_packet_t tap_packet_array[TAP_PACKET_QUEUE_LEN];
-static guint tap_packet_index;
+
+/*
+ * The queue is kept in the epan session, so that packets being dissected
+ * in separate sessions at the same time each have their own.
+ */
+struct tap_packet_queue {
+	gboolean active;	/* the packet being dissected is being tapped */
+	guint index;		/* number of packets queued */
+	tap_packet_t packets[TAP_PACKET_QUEUE_LEN];
+};
 
 typedef struct _tap_listener_t {
 	struct _tap_listener_t *next;
@@ -84,6 +92,7 @@ typedef struct _tap_listener_t {
 	guint flags;
 	gchar *fstring;
 	dfilter_t *code;
+	int filter_idx;		/* index of code in tap_filters, or -1 */
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
@@ -93,6 +102,19 @@ typedef struct _tap_listener_t {
 
 static tap_listener_t *tap_listener_queue=NULL;
 
+/*
+ * The filters of all tap listeners, evaluated together so that the
+ * fields they test are read from the tree once per packet, and the
+ * result of each one for the current packet, so that a listener's
+ * filter is applied once however many times its tap was queued.
+ * Rebuilt whenever a listener or its filter changes.
+ */
+static dfilter_multi_t *tap_filters=NULL;
+static gint8 *tap_filter_results=NULL;
+static guint tap_filter_count=0;
+
+#define TAP_FILTER_UNKNOWN	-1
+
 #ifdef HAVE_PLUGINS
 static GSList *tap_plugins = NULL;
 
@@ -131,7 +153,65 @@ register_all_plugin_tap_listeners(void)
 void
 tap_init(void)
 {
-	tap_packet_index=0;
+}
+
+void
+tap_queue_free(struct tap_packet_queue *queue)
+{
+	g_free(queue);
+}
+
+/* Forget the combined tap filters; this must be done before any
+   listener's filter is freed. */
+static void
+tap_filters_invalidate(void)
+{
+	dfilter_multi_free(tap_filters);
+	tap_filters=NULL;
+	g_free(tap_filter_results);
+	tap_filter_results=NULL;
+	tap_filter_count=0;
+}
+
+/* Combine the filters of all tap listeners and start a new packet */
+static void
+tap_filters_start_packet(void)
+{
+	tap_listener_t *tl;
+
+	if(!tap_filters){
+		tap_filters=dfilter_multi_new();
+		for(tl=tap_listener_queue;tl;tl=tl->next){
+			if(tl->code){
+				tl->filter_idx=(int)dfilter_multi_add(tap_filters, tl->code);
+				tap_filter_count++;
+			} else {
+				tl->filter_idx=-1;
+			}
+		}
+		tap_filter_results=g_new(gint8, tap_filter_count ? tap_filter_count : 1);
+	}
+
+	dfilter_multi_reset(tap_filters);
+	memset(tap_filter_results, TAP_FILTER_UNKNOWN, tap_filter_count);
+}
+
+/* Does the current packet pass the listener's filter? */
+static gboolean
+tap_filter_passes(tap_listener_t *tl, epan_dissect_t *edt)
+{
+	gint8 *result;
+
+	if(!tap_filters){
+		/* A listener changed while the queue was being pushed. */
+		tap_filters_start_packet();
+	}
+
+	result=&tap_filter_results[tl->filter_idx];
+	if(*result==TAP_FILTER_UNKNOWN){
+		*result=dfilter_multi_apply_nth(tap_filters, tl->filter_idx, edt->tree) ? 1 : 0;
+	}
+	return *result!=0;
 }
 
 /* **********************************************************************
@@ -209,28 +289,30 @@ register_tap(const char *name)
 void
 tap_queue_packet(int tap_id, packet_info *pinfo, const void *tap_specific_data)
 {
+	struct tap_packet_queue *queue;
 	tap_packet_t *tpt;
 
-	if(!tapping_is_active){
+	queue = pinfo->epan ? pinfo->epan->tap_queue : NULL;
+	if(!queue || !queue->active){
 		return;
 	}
 	/*
 	 * XXX - should we allocate this with an ep_allocator,
 	 * rather than having a fixed maximum number of entries?
 	 */
-	if(tap_packet_index >= TAP_PACKET_QUEUE_LEN){
+	if(queue->index >= TAP_PACKET_QUEUE_LEN){
 		g_warning("Too many taps queued");
 		return;
 	}
 
-	tpt=&tap_packet_array[tap_packet_index];
+	tpt=&queue->packets[queue->index];
 	tpt->tap_id=tap_id;
 	tpt->flags = 0;
 	if (pinfo->flags.in_error_pkt)
 		tpt->flags |= TAP_PACKET_IS_ERROR_PACKET;
 	tpt->pinfo=pinfo;
 	tpt->tap_specific_data=tap_specific_data;
-	tap_packet_index++;
+	queue->index++;
 }
 
 
@@ -259,21 +341,29 @@ void tap_build_interesting (epan_dissect_t *edt)
 	}
 }
 
-/* This function is used to delete/initialize the tap queue and prime an
-   epan_dissect_t with all the filters for tap listeners.
-   To free the tap queue, we just prepend the used queue to the free queue.
+/* This function is used to delete/initialize the tap queue of the
+   epan_dissect_t's session and prime the epan_dissect_t with all the
+   filters for tap listeners.
 */
 void
 tap_queue_init(epan_dissect_t *edt)
 {
+	struct tap_packet_queue *queue;
+
 	/* nothing to do, just return */
-	if(!tap_listener_queue){
+	if(!tap_listener_queue || !edt->session){
 		return;
 	}
 
-	tapping_is_active=TRUE;
+	queue = edt->session->tap_queue;
+	if(!queue){
+		queue = g_new(struct tap_packet_queue, 1);
+		edt->session->tap_queue = queue;
+	}
+
+	queue->active=TRUE;
 
-	tap_packet_index=0;
+	queue->index=0;
 
 	tap_build_interesting (edt);
 }
@@ -284,27 +374,32 @@ tap_queue_init(epan_dissect_t *edt)
 void
 tap_push_tapped_queue(epan_dissect_t *edt)
 {
+	struct tap_packet_queue *queue;
 	tap_packet_t *tp;
 	tap_listener_t *tl;
 	guint i;
 
+	queue = edt->session ? edt->session->tap_queue : NULL;
+
 	/* nothing to do, just return */
-	if(!tapping_is_active){
+	if(!queue || !queue->active){
 		return;
 	}
 
-	tapping_is_active=FALSE;
+	queue->active=FALSE;
 
 	/* nothing to do, just return */
-	if(!tap_packet_index){
+	if(!queue->index){
 		return;
 	}
 
+	tap_filters_start_packet();
+
 	/* loop over all tap listeners and call the listener callback
 	   for all packets that match the filter. */
-	for(i=0;i<tap_packet_index;i++){
+	for(i=0;i<queue->index;i++){
 		for(tl=tap_listener_queue;tl;tl=tl->next){
-			tp=&tap_packet_array[i];
+			tp=&queue->packets[i];
 			/* Don't tap the packet if it's an "error packet"
 			 * unless the listener has requested that we do so.
 			 */
@@ -330,7 +425,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 					 * packet passes.
 					 */
 					if(tl->code){
-						if (!dfilter_apply_edt(tl->code, edt)){
+						if (!tap_filter_passes(tl, edt)){
 							/* The packet didn't
 							 * pass the filter. */
 							continue;
@@ -377,24 +472,27 @@ tap_push_tapped_queue(epan_dissect_t *edt)
  * the tap listener.
  */
 const void *
-fetch_tapped_data(int tap_id, int idx)
+fetch_tapped_data(packet_info *pinfo, int tap_id, int idx)
 {
+	struct tap_packet_queue *queue;
 	tap_packet_t *tp;
 	guint i;
 
+	queue = pinfo->epan ? pinfo->epan->tap_queue : NULL;
+
 	/* nothing to do, just return */
-	if(!tapping_is_active){
+	if(!queue || !queue->active){
 		return NULL;
 	}
 
 	/* nothing to do, just return */
-	if(!tap_packet_index){
+	if(!queue->index){
 		return NULL;
 	}
 
 	/* loop over all tapped packets and return the one with index idx */
-	for(i=0;i<tap_packet_index;i++){
-		tp=&tap_packet_array[i];
+	for(i=0;i<queue->index;i++){
+		tp=&queue->packets[i];
 		if(tp->tap_id==tap_id){
 			if(!idx--){
 				return tp->tap_specific_data;
@@ -544,6 +642,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 	}
 	tl->fstring=g_strdup(fstring);
 	tl->code=code;
+	tl->filter_idx=-1;
 
 	tl->tap_id=tap_id;
 	tl->tapdata=tapdata;
@@ -553,6 +652,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 	tl->finish=finish;
 	tl->next=tap_listener_queue;
 
+	tap_filters_invalidate();
 	tap_listener_queue=tl;
 
 	return NULL;
@@ -585,6 +685,7 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 	}
 
 	if(tl){
+		tap_filters_invalidate();
 		if(tl->code){
 			dfilter_free(tl->code);
 			tl->code=NULL;
@@ -618,6 +719,7 @@ tap_listeners_dfilter_recompile(void)
 	dfilter_t *code;
 	gchar *err_msg;
 
+	tap_filters_invalidate();
 	for(tl=tap_listener_queue;tl;tl=tl->next){
 		if(tl->code){
 			dfilter_free(tl->code);
@@ -666,6 +768,7 @@ remove_tap_listener(void *tapdata)
 			return;
 		}
 	}
+	tap_filters_invalidate();
 	free_tap_listener(tl);
 }
 
@@ -744,6 +847,9 @@ void tap_cleanup(void)
 	tap_dissector_t *elem_dl;
 	tap_dissector_t *head_dl = tap_dissector_list;
 
+	/* The combined filters point at the listeners' filters */
+	tap_filters_invalidate();
+
 	while(head_lq){
 		elem_lq = head_lq;
 		head_lq = head_lq->next;
@@ -68,6 +68,12 @@ WS_DLL_PUBLIC void register_all_plugin_tap_listeners(void);
 
 extern void tap_init(void);
 
+struct tap_packet_queue;
+
+/** Free the tap queue of an epan session.
+ */
+extern void tap_queue_free(struct tap_packet_queue *queue);
+
 /** This function registers that a dissector has the packet tap ability
  *  available.  The name parameter is the name of this tap and extensions can
  *  use open_tap(char *name,... to specify that it wants to receive packets/
@@ -115,9 +121,9 @@ WS_DLL_PUBLIC void tap_queue_packet(int tap_id, packet_info *pinfo, const void *
 /** Functions used by file.c to drive the tap subsystem */
 WS_DLL_PUBLIC void tap_build_interesting(epan_dissect_t *edt);
 
-/** This function is used to delete/initialize the tap queue and prime an
- *  epan_dissect_t with all the filters for tap listeners.
- *  To free the tap queue, we just prepend the used queue to the free queue.
+/** This function is used to delete/initialize the tap queue of the
+ *  epan_dissect_t's session and prime the epan_dissect_t with all the
+ *  filters for tap listeners.
  */
 extern void tap_queue_init(epan_dissect_t *edt);
 
@@ -265,7 +271,7 @@ WS_DLL_PUBLIC guint union_of_tap_listener_flags(void);
  * use "filters" and should specify the "filter" as NULL when registering
  * the tap listener.
  */
-WS_DLL_PUBLIC const void *fetch_tapped_data(int tap_id, int idx);
+WS_DLL_PUBLIC const void *fetch_tapped_data(packet_info *pinfo, int tap_id, int idx);
 
 /** Clean internal structures
  */
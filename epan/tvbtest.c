@@ -18,6 +18,7 @@
 #include "tvbuff.h"
 #include "exceptions.h"
 #include "wsutil/pint.h"
+#include "wsutil/ws_mempbrk.h"
 
 gboolean failed = FALSE;
 
@@ -485,6 +486,245 @@ run_tests(void)
 	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
 }
 
+/* Text that looks like the headers of an HTTP request, for the search tests. */
+static const gchar search_text[] =
+	"GET /index.html HTTP/1.1\r\n"
+	"Host: www.example.com\r\n"
+	"User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:60.0) Gecko/20100101 Firefox/60.0\r\n"
+	"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+	"Accept-Language: en-US,en;q=0.5\r\n"
+	"Accept-Encoding: gzip, deflate\r\n"
+	"Cookie: \"session=0123456789abcdef\"; theme=dark\n"
+	"Connection: keep-alive\r\n"
+	"\r\n";
+
+static void
+search_failed(const gchar *what, gint offset, gint got, gint expected)
+{
+	printf("Failed search %s at offset %d: got %d, expected %d\n",
+	    what, offset, got, expected);
+	failed = TRUE;
+}
+
+/* Compare the tvb search routines with a byte-by-byte search, starting
+ * at every offset so that every alignment and tail length is covered. */
+static void
+run_search_tests(void)
+{
+	const gint	len = (gint)strlen(search_text);
+	const guint8	*data = (const guint8 *)search_text;
+	tvbuff_t	*tvb;
+	tvbuff_t	*needle_tvb;
+	ws_mempbrk_pattern pattern;
+	guchar		found_needle;
+	gint		offset, i, expected, got, next_offset;
+
+	tvb = tvb_new_real_data(data, len, len);
+	needle_tvb = tvb_new_real_data((const guint8 *)"q=0.", 4, 4);
+	memset(&pattern, 0, sizeof pattern);
+	ws_mempbrk_compile(&pattern, "\r\n\"");
+
+	for (offset = 0; offset <= len; offset++) {
+		expected = -1;
+		for (i = offset; i < len; i++) {
+			if (data[i] == ';') {
+				expected = i;
+				break;
+			}
+		}
+		got = tvb_find_guint8(tvb, offset, -1, ';');
+		if (got != expected)
+			search_failed("tvb_find_guint8", offset, got, expected);
+
+		expected = -1;
+		for (i = offset; i < len; i++) {
+			if (data[i] == '\r' || data[i] == '\n' || data[i] == '"') {
+				expected = i;
+				break;
+			}
+		}
+		found_needle = 0;
+		got = tvb_ws_mempbrk_pattern_guint8(tvb, offset, -1, &pattern, &found_needle);
+		if (got != expected || (got != -1 && found_needle != data[got]))
+			search_failed("tvb_ws_mempbrk_pattern_guint8", offset, got, expected);
+
+		/* tvb_find_line_end() returns the line length, not an offset. */
+		for (i = offset; i < len && data[i] != '\r' && data[i] != '\n'; i++)
+			;
+		expected = i - offset;
+		got = tvb_find_line_end(tvb, offset, -1, &next_offset, FALSE);
+		if (got != expected)
+			search_failed("tvb_find_line_end", offset, got, expected);
+
+		expected = -1;
+		for (i = offset; i + 4 <= len; i++) {
+			if (memcmp(data + i, "q=0.", 4) == 0) {
+				expected = i;
+				break;
+			}
+		}
+		got = tvb_find_tvb(tvb, needle_tvb, offset);
+		if (got != expected)
+			search_failed("tvb_find_tvb", offset, got, expected);
+	}
+
+	if (!failed)
+		printf("Passed search tests\n");
+
+	tvb_free(needle_tvb);
+	tvb_free(tvb);
+}
+
+/* Time splitting the search text into lines, as a text protocol dissector
+ * would; this only reports the time, it doesn't check it. */
+static void
+run_search_benchmark(void)
+{
+	const gint	len = (gint)strlen(search_text);
+	tvbuff_t	*tvb;
+	gint		offset, next_offset, lines = 0;
+	gint64		start_time, elapsed;
+	int		iter;
+#define SEARCH_BENCHMARK_ITERATIONS 20000
+
+	tvb = tvb_new_real_data((const guint8 *)search_text, len, len);
+
+	start_time = g_get_monotonic_time();
+	for (iter = 0; iter < SEARCH_BENCHMARK_ITERATIONS; iter++) {
+		for (offset = 0; offset < len; offset = next_offset) {
+			tvb_find_line_end(tvb, offset, -1, &next_offset, FALSE);
+			lines++;
+		}
+	}
+	elapsed = g_get_monotonic_time() - start_time;
+
+	printf("tvb_find_line_end: %d lines in %" G_GINT64_MODIFIER "d us (%.1f ns/line)\n",
+	    lines, elapsed, lines ? 1000.0 * (double)elapsed / lines : 0.0);
+
+	tvb_free(tvb);
+}
+
+/* Build a composite out of many small members, half of them appended
+ * after finalization, and check random ranges against a flat copy. */
+static void
+run_composite_tests(void)
+{
+#define COMPOSITE_MEMBERS	2000
+#define COMPOSITE_MAX_MEMBER	37
+	guint8		*flat;
+	guint8		*buf;
+	guint8		*member_data;
+	tvbuff_t	*tvb;
+	tvbuff_t	*member;
+	const guint8	*ptr;
+	guint		i, j, member_len, total = 0;
+	guint		offset, len;
+	GRand		*rand;
+
+	rand = g_rand_new_with_seed(0x20c0);
+	flat = (guint8 *)g_malloc(COMPOSITE_MEMBERS * COMPOSITE_MAX_MEMBER);
+	buf = (guint8 *)g_malloc(COMPOSITE_MEMBERS * COMPOSITE_MAX_MEMBER);
+
+	tvb = tvb_new_owning_composite();
+	for (i = 0; i < COMPOSITE_MEMBERS; i++) {
+		member_len = (guint)g_rand_int_range(rand, 1, COMPOSITE_MAX_MEMBER + 1);
+		member_data = (guint8 *)g_malloc(member_len);
+		for (j = 0; j < member_len; j++)
+			member_data[j] = flat[total + j] = (guint8)g_rand_int(rand);
+		member = tvb_new_real_data(member_data, member_len, member_len);
+		tvb_set_free_cb(member, g_free);
+		tvb_composite_append(tvb, member);
+		total += member_len;
+
+		if (i == COMPOSITE_MEMBERS / 2 - 1) {
+			tvb_composite_finalize(tvb);
+			/* Flatten it, so the appends below must retire the copy. */
+			ptr = tvb_get_ptr(tvb, 0, total);
+			if (memcmp(ptr, flat, total) != 0) {
+				printf("Failed composite: flattened data differs\n");
+				failed = TRUE;
+			}
+		}
+	}
+
+	if (tvb_captured_length(tvb) != total || tvb_reported_length(tvb) != total) {
+		printf("Failed composite: length %u, expected %u\n",
+		    tvb_captured_length(tvb), total);
+		failed = TRUE;
+	}
+
+	for (i = 0; i < 10000 && !failed; i++) {
+		offset = (guint)g_rand_int_range(rand, 0, total);
+		len = (guint)g_rand_int_range(rand, 0, MIN(total - offset, 4 * COMPOSITE_MAX_MEMBER) + 1);
+		tvb_memcpy(tvb, buf, offset, len);
+		if (memcmp(buf, flat + offset, len) != 0) {
+			printf("Failed composite: tvb_memcpy at %u len %u\n", offset, len);
+			failed = TRUE;
+		}
+		if (tvb_get_guint8(tvb, offset) != flat[offset]) {
+			printf("Failed composite: tvb_get_guint8 at %u\n", offset);
+			failed = TRUE;
+		}
+	}
+	ptr = tvb_get_ptr(tvb, 0, total);
+	if (memcmp(ptr, flat, total) != 0) {
+		printf("Failed composite: flattened data differs after appends\n");
+		failed = TRUE;
+	}
+
+	tvb_free(tvb);	/* frees the members as well */
+
+	/* Data within one member is read from that member, and only a
+	 * range that spans members flattens the composite. */
+	tvb = tvb_new_owning_composite();
+	member_data = (guint8 *)g_strdup("abcd");
+	member = tvb_new_real_data(member_data, 4, 4);
+	tvb_set_free_cb(member, g_free);
+	tvb_composite_append(tvb, member);
+	member = tvb_new_real_data((const guint8 *)"efgh", 4, 4);
+	tvb_composite_append(tvb, member);
+	tvb_composite_finalize(tvb);
+	ptr = tvb_get_ptr(tvb, 1, 2);
+	if (ptr != member_data + 1 || tvb_get_guint8(tvb, 5) != 'f') {
+		printf("Failed composite: a range within a member wasn't read from it\n");
+		failed = TRUE;
+	}
+	if (tvb_contiguous_length(tvb, 1, 6) != 3 || tvb_contiguous_length(tvb, 4, 4) != 4) {
+		printf("Failed composite: contiguous length within members\n");
+		failed = TRUE;
+	}
+	if (memcmp(tvb_get_ptr(tvb, 2, 4), "cdef", 4) != 0 ||
+	    memcmp(ptr, "bc", 2) != 0) {
+		printf("Failed composite: flattening a range that spans members\n");
+		failed = TRUE;
+	}
+	if (tvb_contiguous_length(tvb, 1, 6) != 6) {
+		printf("Failed composite: contiguous length after flattening\n");
+		failed = TRUE;
+	}
+	tvb_free(tvb);
+
+	/* A pointer into the only member must stay valid when appends
+	 * make the composite get flattened. */
+	tvb = tvb_new_owning_composite();
+	member = tvb_new_real_data((const guint8 *)"abcd", 4, 4);
+	tvb_composite_append(tvb, member);
+	tvb_composite_finalize(tvb);
+	ptr = tvb_get_ptr(tvb, 1, 2);
+	member = tvb_new_real_data((const guint8 *)"efgh", 4, 4);
+	tvb_composite_append(tvb, member);
+	if (memcmp(tvb_get_ptr(tvb, 0, 8), "abcdefgh", 8) != 0 ||
+	    memcmp(ptr, "bc", 2) != 0) {
+		printf("Failed composite: flattening after handing out a member pointer\n");
+		failed = TRUE;
+	}
+	tvb_free(tvb);
+
+	g_free(buf);
+	g_free(flat);
+	g_rand_free(rand);
+}
+
 /* Note: valgrind can be used to check for tvbuff memory leaks */
 int
 main(void)
@@ -495,6 +735,9 @@ main(void)
 
 	except_init();
 	run_tests();
+	run_composite_tests();
+	run_search_tests();
+	run_search_benchmark();
 	except_deinit();
 	exit(failed?1:0);
 }
@@ -25,6 +25,8 @@ struct tvb_ops {
 	gint (*tvb_ws_mempbrk_pattern_guint8)(tvbuff_t *tvb, guint abs_offset, guint limit, const ws_mempbrk_pattern* pattern, guchar *found_needle);
 
 	tvbuff_t *(*tvb_clone)(tvbuff_t *tvb, guint abs_offset, guint abs_length);
+
+	guint (*tvb_contiguous_length)(tvbuff_t *tvb, guint abs_offset, guint abs_length);
 };
 
 /*
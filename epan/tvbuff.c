@@ -914,6 +914,21 @@ tvb_get_ptr(tvbuff_t *tvb, const gint offset, const gint length)
 	return ensure_contiguous(tvb, offset, length);
 }
 
+guint
+tvb_contiguous_length(tvbuff_t *tvb, const gint offset, const gint length)
+{
+	guint abs_offset = 0, abs_length = 0;
+
+	DISSECTOR_ASSERT(tvb && tvb->initialized);
+
+	check_offset_length(tvb, offset, length, &abs_offset, &abs_length);
+
+	if (tvb->real_data || abs_length == 0 || !tvb->ops->tvb_contiguous_length)
+		return abs_length;
+
+	return tvb->ops->tvb_contiguous_length(tvb, abs_offset, abs_length);
+}
+
 /* ---------------- */
 guint8
 tvb_get_guint8(tvbuff_t *tvb, const gint offset)
@@ -195,7 +195,9 @@ WS_DLL_PUBLIC tvbuff_t *tvb_new_subset_remaining(tvbuff_t *backing,
  * BoundsError if member_offset/member_length goes beyond bounds of
  * the 'member' tvbuff. */
 
-/** Append to the list of tvbuffs that make up this composite tvbuff */
+/** Append to the list of tvbuffs that make up this composite tvbuff.
+ * Appending to a finalized composite extends it in place; offsets into
+ * the data that was already there remain valid. */
 WS_DLL_PUBLIC void tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member);
 
 /** Prepend to the list of tvbuffs that make up this composite tvbuff */
@@ -204,8 +206,17 @@ extern void tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member);
 /** Create an empty composite tvbuff. */
 WS_DLL_PUBLIC tvbuff_t *tvb_new_composite(void);
 
-/** Mark a composite tvbuff as initialized. No further appends or prepends
- * occur, data access can finally happen after this finalization. */
+/** Create an empty composite tvbuff that owns its members: they are freed
+ * when the composite is freed, and the composite is not chained to its
+ * first member.  Data within one member is read from that member; the
+ * first tvb_get_ptr() (or any accessor that needs contiguous data) of a
+ * range that spans members copies the composite into a single buffer, and
+ * frees the members unless a pointer into one of them has been handed
+ * out. */
+WS_DLL_PUBLIC tvbuff_t *tvb_new_owning_composite(void);
+
+/** Mark a composite tvbuff as initialized. No further prepends occur,
+ * data access can finally happen after this finalization. */
 WS_DLL_PUBLIC void tvb_composite_finalize(tvbuff_t *tvb);
 
 
@@ -488,6 +499,15 @@ WS_DLL_PUBLIC void *tvb_memdup(wmem_allocator_t *scope, tvbuff_t *tvb,
 WS_DLL_PUBLIC const guint8 *tvb_get_ptr(tvbuff_t *tvb, const gint offset,
     const gint length);
 
+/** Returns how many of the 'length' bytes at 'offset' are contiguous in the
+ * tvbuff, i.e. can be had from tvb_get_ptr() without copying the data into
+ * a new buffer; that's at least one byte, unless 'length' is 0.  To go
+ * through data that may be in a "composite" tvbuff, call tvb_get_ptr() on
+ * that many bytes and repeat for the rest.  Throws an exception if the
+ * bytes aren't all in the tvbuff. */
+WS_DLL_PUBLIC guint tvb_contiguous_length(tvbuff_t *tvb, const gint offset,
+    const gint length);
+
 /** Find first occurrence of needle in tvbuff, starting at offset. Searches
  * at most maxlength number of bytes; if maxlength is -1, searches to
  * end of tvbuff.
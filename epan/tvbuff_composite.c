@@ -16,14 +16,27 @@
 #include "proto.h"	/* XXX - only used for DISSECTOR_ASSERT, probably a new header file? */
 
 typedef struct {
-	GSList		*tvbs;
-
-	/* Used for quick testing to see if this
-	 * is the tvbuff that a COMPOSITE is
-	 * interested in. */
+	tvbuff_t	**members;
+	guint		num_members;
+	guint		alloc_members;
+
+	/* start_offsets[i] is the offset of member i within the
+	 * composite; start_offsets[num_members] is the total captured
+	 * length. It's kept up to date on every append, so that an
+	 * offset can be mapped to its member with a binary search. */
 	guint		*start_offsets;
-	guint		*end_offsets;
 
+	/* TRUE if the members are freed along with the composite. */
+	gboolean	owns_members;
+
+	/* TRUE if a pointer into a member's data has been handed out,
+	 * so the members must stay around after flattening. */
+	gboolean	member_ptrs_out;
+
+	/* Flattened copies of the data that were made obsolete by
+	 * appends after finalization; pointers into them may still
+	 * be held by dissectors, so they live as long as the tvb. */
+	GSList		*retired_data;
 } tvb_comp_t;
 
 struct tvb_composite {
@@ -37,11 +50,15 @@ composite_free(tvbuff_t *tvb)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite = &composite_tvb->composite;
+	guint i;
 
-	g_slist_free(composite->tvbs);
-
+	if (composite->owns_members) {
+		for (i = 0; i < composite->num_members; i++)
+			tvb_free(composite->members[i]);
+	}
+	g_free(composite->members);
 	g_free(composite->start_offsets);
-	g_free(composite->end_offsets);
+	g_slist_free_full(composite->retired_data, g_free);
 	if (tvb->real_data) {
 		/*
 		 * XXX - do this with a union?
@@ -56,37 +73,82 @@ composite_offset(const tvbuff_t *tvb _U_, const guint counter)
 	return counter;
 }
 
+/*
+ * Return the index of the member containing abs_offset, or num_members
+ * if abs_offset is at (or past) the end of the composite.
+ */
+static guint
+composite_find_member(const tvb_comp_t *composite, const guint abs_offset)
+{
+	guint lo = 0, hi = composite->num_members;
+	guint mid;
+
+	if (abs_offset >= composite->start_offsets[hi])
+		return hi;
+
+	/* Find the last member that starts at or before abs_offset. */
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		if (composite->start_offsets[mid] <= abs_offset)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/*
+ * Copy the whole composite into one buffer.  The members of an owning
+ * composite aren't needed after that, unless a pointer into them has been
+ * handed out, so they're swapped for a single member wrapping the copy;
+ * that keeps appends after finalization working.
+ */
+static const guint8*
+composite_flatten(tvbuff_t *tvb)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	/* Use a temporary variable as tvb_memcpy is also checking tvb->real_data pointer */
+	void *real_data = g_malloc(tvb->length);
+	guint i;
+
+	tvb_memcpy(tvb, real_data, 0, tvb->length);
+	tvb->real_data = (const guint8 *)real_data;
+
+	if (composite->owns_members && !composite->member_ptrs_out) {
+		for (i = 0; i < composite->num_members; i++)
+			tvb_free(composite->members[i]);
+		composite->members[0] = tvb_new_real_data(tvb->real_data, tvb->length, tvb->length);
+		composite->num_members = 1;
+		composite->start_offsets[1] = tvb->length;
+	}
+
+	return tvb->real_data;
+}
+
 static const guint8*
 composite_get_ptr(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset;
-	GSList	   *slist;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
 	/* Maybe the range specified by offset/length
 	 * is contiguous inside one of the member tvbuffs */
 	composite = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return "";
 	}
 
+	member_tvb = composite->members[i];
 	member_offset = abs_offset - composite->start_offsets[i];
 
 	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
@@ -94,14 +156,15 @@ composite_get_ptr(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 		 * The range is, in fact, contiguous within member_tvb.
 		 */
 		DISSECTOR_ASSERT(!tvb->real_data);
+		composite->member_ptrs_out = TRUE;
 		return tvb_get_ptr(member_tvb, member_offset, abs_length);
 	}
 	else {
-		/* Use a temporary variable as tvb_memcpy is also checking tvb->real_data pointer */
-		void *real_data = g_malloc(tvb->length);
-		tvb_memcpy(tvb, real_data, 0, tvb->length);
-		tvb->real_data = (const guint8 *)real_data;
-		return tvb->real_data + abs_offset;
+		/*
+		 * The range spans members, so the whole composite has to
+		 * be copied into one buffer.
+		 */
+		return composite_flatten(tvb) + abs_offset;
 	}
 
 	DISSECTOR_ASSERT_NOT_REACHED();
@@ -113,63 +176,63 @@ composite_memcpy(tvbuff_t *tvb, void* _target, guint abs_offset, guint abs_lengt
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	guint8 *target = (guint8 *) _target;
 
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset, member_length;
-	GSList	   *slist;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
-	/* Maybe the range specified by offset/length
-	 * is contiguous inside one of the member tvbuffs */
-	composite   = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	composite = &composite_tvb->composite;
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return target;
 	}
 
 	member_offset = abs_offset - composite->start_offsets[i];
 
-	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
-		DISSECTOR_ASSERT(!tvb->real_data);
-		return tvb_memcpy(member_tvb, target, member_offset, abs_length);
-	}
-	else {
-		/* The requested data is non-contiguous inside
-		 * the member tvb. We have to memcpy() the part that's in the member tvb,
-		 * then iterate across the other member tvb's, copying their portions
-		 * until we have copied all data.
-		 */
+	/* Copy the part that's in the first member, then walk the
+	 * following members, copying their portions until we have
+	 * copied all data. */
+	while (abs_length > 0) {
+		DISSECTOR_ASSERT(i < composite->num_members);
+		member_tvb = composite->members[i];
+
 		member_length = tvb_captured_length_remaining(member_tvb, member_offset);
 
-		/* composite_memcpy() can't handle a member_length of zero. */
+		/* Members are never zero-length, see tvb_composite_append(). */
 		DISSECTOR_ASSERT(member_length > 0);
 
+		if (member_length > abs_length)
+			member_length = abs_length;
+
 		tvb_memcpy(member_tvb, target, member_offset, member_length);
-		abs_offset	+= member_length;
+		target		+= member_length;
 		abs_length	-= member_length;
+		member_offset	 = 0;
+		i++;
+	}
 
-		/* Recurse */
-		if (abs_length > 0) {
-			composite_memcpy(tvb, target + member_length, abs_offset, abs_length);
-		}
+	return _target;
+}
 
-		return target;
-	}
+static guint
+composite_contiguous_length(tvbuff_t *tvb, guint abs_offset, guint abs_length)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	guint	    i, member_length;
 
-	DISSECTOR_ASSERT_NOT_REACHED();
+	/* The caller has checked the range, and it isn't empty. */
+	i = composite_find_member(composite, abs_offset);
+	member_length = composite->start_offsets[i + 1] - abs_offset;
+	if (member_length > abs_length)
+		member_length = abs_length;
+
+	return tvb_contiguous_length(composite->members[i], abs_offset - composite->start_offsets[i], member_length);
 }
 
 static const struct tvb_ops tvb_composite_ops = {
@@ -182,8 +245,28 @@ static const struct tvb_ops tvb_composite_ops = {
 	NULL,                 /* find_guint8 XXX */
 	NULL,                 /* pbrk_guint8 XXX */
 	NULL,                 /* clone */
+	composite_contiguous_length, /* contiguous_length */
 };
 
+static tvbuff_t *
+composite_new(gboolean owns_members)
+{
+	tvbuff_t *tvb = tvb_new(&tvb_composite_ops);
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+
+	composite->members	 = NULL;
+	composite->num_members	 = 0;
+	composite->alloc_members = 0;
+	composite->start_offsets = g_new(guint, 1);
+	composite->start_offsets[0] = 0;
+	composite->owns_members	 = owns_members;
+	composite->member_ptrs_out = FALSE;
+	composite->retired_data	 = NULL;
+
+	return tvb;
+}
+
 /*
  * Composite tvb
  *
@@ -195,15 +278,28 @@ static const struct tvb_ops tvb_composite_ops = {
 tvbuff_t *
 tvb_new_composite(void)
 {
-	tvbuff_t *tvb = tvb_new(&tvb_composite_ops);
-	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	tvb_comp_t *composite = &composite_tvb->composite;
+	return composite_new(FALSE);
+}
 
-	composite->tvbs		 = NULL;
-	composite->start_offsets = NULL;
-	composite->end_offsets	 = NULL;
+/*
+ * An owning composite is not chained to anything: its members are
+ * handed over to it and freed by composite_free().
+ */
+tvbuff_t *
+tvb_new_owning_composite(void)
+{
+	return composite_new(TRUE);
+}
 
-	return tvb;
+static void
+composite_grow(tvb_comp_t *composite)
+{
+	if (composite->num_members < composite->alloc_members)
+		return;
+
+	composite->alloc_members = composite->alloc_members ? composite->alloc_members * 2 : 4;
+	composite->members = g_renew(tvbuff_t *, composite->members, composite->alloc_members);
+	composite->start_offsets = g_renew(guint, composite->start_offsets, composite->alloc_members + 1);
 }
 
 void
@@ -212,7 +308,7 @@ tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member)
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite;
 
-	DISSECTOR_ASSERT(tvb && !tvb->initialized);
+	DISSECTOR_ASSERT(tvb);
 	DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops);
 
 	/* Don't allow zero-length TVBs: composite_memcpy() can't handle them
@@ -220,8 +316,28 @@ tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member)
 	 */
 	DISSECTOR_ASSERT(member->length);
 
-	composite       = &composite_tvb->composite;
-	composite->tvbs = g_slist_append(composite->tvbs, member);
+	composite = &composite_tvb->composite;
+	composite_grow(composite);
+	composite->members[composite->num_members] = member;
+	composite->start_offsets[composite->num_members + 1] =
+	    composite->start_offsets[composite->num_members] + member->length;
+	composite->num_members++;
+
+	if (tvb->initialized) {
+		/*
+		 * Appending to a finalized composite just extends it;
+		 * the data already there doesn't move.  A flattened copy
+		 * is now too short, so retire it rather than freeing it,
+		 * as it may still be referenced.
+		 */
+		tvb->length += member->length;
+		tvb->reported_length += member->reported_length;
+		tvb->contained_length += member->contained_length;
+		if (tvb->real_data) {
+			composite->retired_data = g_slist_prepend(composite->retired_data, (gpointer)tvb->real_data);
+			tvb->real_data = NULL;
+		}
+	}
 }
 
 void
@@ -229,6 +345,7 @@ tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite;
+	guint	    i;
 
 	DISSECTOR_ASSERT(tvb && !tvb->initialized);
 	DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops);
@@ -238,19 +355,25 @@ tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member)
 	 */
 	DISSECTOR_ASSERT(member->length);
 
-	composite       = &composite_tvb->composite;
-	composite->tvbs = g_slist_prepend(composite->tvbs, member);
+	composite = &composite_tvb->composite;
+	composite_grow(composite);
+	for (i = composite->num_members; i > 0; i--) {
+		composite->members[i] = composite->members[i - 1];
+		composite->start_offsets[i + 1] = composite->start_offsets[i] + member->length;
+	}
+	composite->members[0] = member;
+	composite->start_offsets[1] = member->length;
+	composite->start_offsets[0] = 0;
+	composite->num_members++;
 }
 
 void
 tvb_composite_finalize(tvbuff_t *tvb)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	GSList	   *slist;
-	guint	    num_members;
 	tvbuff_t   *member_tvb;
 	tvb_comp_t *composite;
-	int	    i = 0;
+	guint	    i;
 
 	DISSECTOR_ASSERT(tvb && !tvb->initialized);
 	DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops);
@@ -258,32 +381,23 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	DISSECTOR_ASSERT(tvb->reported_length == 0);
 	DISSECTOR_ASSERT(tvb->contained_length == 0);
 
-	composite   = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
+	composite = &composite_tvb->composite;
 
 	/* Dissectors should not create composite TVBs if they're not going to
 	 * put at least one TVB in them.
 	 * (Without this check--or something similar--we'll seg-fault below.)
 	 */
-	DISSECTOR_ASSERT(num_members);
-
-	composite->start_offsets = g_new(guint, num_members);
-	composite->end_offsets = g_new(guint, num_members);
+	DISSECTOR_ASSERT(composite->num_members);
 
-	for (slist = composite->tvbs; slist != NULL; slist = slist->next) {
-		DISSECTOR_ASSERT((guint) i < num_members);
-		member_tvb = (tvbuff_t *)slist->data;
-		composite->start_offsets[i] = tvb->length;
-		tvb->length += member_tvb->length;
+	for (i = 0; i < composite->num_members; i++) {
+		member_tvb = composite->members[i];
 		tvb->reported_length += member_tvb->reported_length;
 		tvb->contained_length += member_tvb->contained_length;
-		composite->end_offsets[i] = tvb->length - 1;
-		i++;
 	}
+	tvb->length = composite->start_offsets[composite->num_members];
 
-	DISSECTOR_ASSERT(composite->tvbs);
-
-	tvb_add_to_chain((tvbuff_t *)composite->tvbs->data, tvb); /* chain composite tvb to first member */
+	if (!composite->owns_members)
+		tvb_add_to_chain(composite->members[0], tvb); /* chain composite tvb to first member */
 	tvb->initialized = TRUE;
 	tvb->ds_tvb = tvb;
 }
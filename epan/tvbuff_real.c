@@ -52,6 +52,7 @@ static const struct tvb_ops tvb_real_ops = {
 	NULL,                 /* find_guint8 */
 	NULL,                 /* pbrk_guint8 */
 	NULL,                 /* clone */
+	NULL,                 /* contiguous_length */
 };
 
 tvbuff_t *
@@ -82,6 +82,14 @@ subset_clone(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 	return tvb_clone_offset_len(subset_tvb->subset.tvb, subset_tvb->subset.offset + abs_offset, abs_length);
 }
 
+static guint
+subset_contiguous_length(tvbuff_t *tvb, guint abs_offset, guint abs_length)
+{
+	struct tvb_subset *subset_tvb = (struct tvb_subset *) tvb;
+
+	return tvb_contiguous_length(subset_tvb->subset.tvb, subset_tvb->subset.offset + abs_offset, abs_length);
+}
+
 static const struct tvb_ops tvb_subset_ops = {
 	sizeof(struct tvb_subset), /* size */
 
@@ -92,6 +100,7 @@ static const struct tvb_ops tvb_subset_ops = {
 	subset_find_guint8,   /* find_guint8 */
 	subset_pbrk_guint8,   /* pbrk_guint8 */
 	subset_clone,         /* clone */
+	subset_contiguous_length, /* contiguous_length */
 };
 
 static tvbuff_t *
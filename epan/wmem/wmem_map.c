@@ -10,7 +10,11 @@
  */
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
+#include <wsutil/bits_ctz.h>
+#include <wsutil/ws_sse2.h>
 
 #include "wmem_core.h"
 #include "wmem_list.h"
@@ -18,7 +22,7 @@
 #include "wmem_map_int.h"
 #include "wmem_user_cb.h"
 
-static guint32 x; /* Used for universal integer hashing (see the HASH macro) */
+static guint64 x; /* Used for universal integer hashing (see wmem_map_hash) */
 
 /* Used for the wmem_strong_hash() function */
 static guint32 preseed;
@@ -27,22 +31,40 @@ static guint32 postseed;
 void
 wmem_init_hashing(void)
 {
-    x = g_random_int();
-    if (G_UNLIKELY(x == 0))
-        x = 1;
+    /* The multiplier has to be odd to mix every bit of the hash in. */
+    x = ((guint64)g_random_int() << 32) | g_random_int() | 1;
 
     preseed  = g_random_int();
     postseed = g_random_int();
 }
 
-typedef struct _wmem_map_item_t {
+/* The map is an open-addressing table in the style of Abseil's "Swiss
+ * tables": alongside the array of slots there is an array of one-byte control
+ * values, one per slot, which say whether the slot is empty, deleted, or full;
+ * for a full slot it also holds 7 bits of the key's hash. A lookup looks at a
+ * whole group of control bytes at once (16 with SSE2, 8 otherwise) and only
+ * calls the equality function for slots whose 7 hash bits match, so most
+ * lookups touch one group of control bytes and one slot, and no pointers are
+ * chased.
+ *
+ * Groups are aligned, and are probed quadratically (which visits every group
+ * as the number of groups is a power of 2). A lookup stops at the first group
+ * that has an empty slot. A removed slot is only marked empty again if its
+ * group still has an empty slot, as otherwise a lookup could stop short of a
+ * key that was pushed past the group while it was full; otherwise it is marked
+ * deleted, and reclaimed when the table is next rebuilt. */
+#define CTRL_EMPTY   ((guint8)0x80)
+#define CTRL_DELETED ((guint8)0xFE)
+/* A full slot has the high bit clear; the rest is the hash's H2 value. */
+
+typedef struct _wmem_map_slot_t {
     const void *key;
     void *value;
-    struct _wmem_map_item_t *next;
-} wmem_map_item_t;
+} wmem_map_slot_t;
 
 struct _wmem_map_t {
-    guint count; /* number of items stored */
+    guint count;   /* number of items stored */
+    guint deleted; /* number of slots marked deleted */
 
     /* The base-2 logarithm of the actual size of the table. We store this
      * value for efficiency in hashing, since finding the actual capacity
@@ -50,7 +72,8 @@ struct _wmem_map_t {
      * logarithms is expensive. */
     size_t capacity;
 
-    wmem_map_item_t **table;
+    wmem_map_slot_t *table;
+    guint8          *ctrl;
 
     GHashFunc  hash_func;
     GEqualFunc eql_func;
@@ -62,6 +85,12 @@ struct _wmem_map_t {
     wmem_allocator_t *allocator;
 };
 
+#ifdef WS_HAVE_SSE2
+#define GROUP_WIDTH 16
+#else
+#define GROUP_WIDTH 8
+#endif
+
 /* As per the comment on the 'capacity' member of the wmem_map_t struct, this is
  * the base-2 logarithm, meaning the actual default capacity is 2^5 = 32 */
 #define WMEM_MAP_DEFAULT_CAPACITY 5
@@ -70,18 +99,114 @@ struct _wmem_map_t {
  * do the 2^x operation. */
 #define CAPACITY(MAP) (((size_t)1) << (MAP)->capacity)
 
+/* The table is rebuilt once 7/8 of its slots are used or deleted. */
+#define MAX_LOAD(MAP) (CAPACITY(MAP) - CAPACITY(MAP) / 8)
+
 /* Efficient universal integer hashing:
  * https://en.wikipedia.org/wiki/Universal_hashing#Avoiding_modular_arithmetic
- */
-#define HASH(MAP, KEY) \
-    ((guint32)(((MAP)->hash_func(KEY) * x) >> (32 - (MAP)->capacity)))
+ * The top bits of the product pick the first group to probe (H1), and seven
+ * bits below the low 32 go in the control byte (H2). */
+static inline guint64
+wmem_map_hash(const wmem_map_t *map, const void *key)
+{
+    return (guint64)map->hash_func(key) * x;
+}
+
+#define H1(MAP, HASH) ((size_t)((HASH) >> (64 - (MAP)->capacity)))
+#define H2(HASH)      ((guint8)(((HASH) >> 25) & 0x7F))
+
+/* Matching a group of control bytes gives a bit mask, which the MATCH_*
+ * macros below walk through, lowest slot first. */
+#ifdef WS_HAVE_SSE2
+typedef guint32 group_mask_t;
+
+static inline group_mask_t
+group_match(const guint8 *ctrl, guint8 h2)
+{
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return (group_mask_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8((char)h2), group));
+}
+
+static inline group_mask_t
+group_match_empty(const guint8 *ctrl)
+{
+    return group_match(ctrl, CTRL_EMPTY);
+}
+
+static inline group_mask_t
+group_match_empty_or_deleted(const guint8 *ctrl)
+{
+    /* Both have the high bit set. */
+    return (group_mask_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+}
+
+#define MASK_SHIFT 0
+#else
+/* Without SSE2, work on 8 control bytes in a 64-bit word; the match for a
+ * byte is its high bit. */
+typedef guint64 group_mask_t;
+
+#define GROUP_LSBS G_GUINT64_CONSTANT(0x0101010101010101)
+#define GROUP_MSBS G_GUINT64_CONSTANT(0x8080808080808080)
+
+static inline guint64
+group_load(const guint8 *ctrl)
+{
+    guint64 group;
+
+    memcpy(&group, ctrl, sizeof group);
+    return GUINT64_FROM_LE(group);
+}
+
+static inline group_mask_t
+group_match(const guint8 *ctrl, guint8 h2)
+{
+    /* This can report a byte after a real match that doesn't match, which
+     * is harmless, as the keys are compared anyway. */
+    guint64 group = group_load(ctrl) ^ (GROUP_LSBS * h2);
+    return (group - GROUP_LSBS) & ~group & GROUP_MSBS;
+}
+
+static inline group_mask_t
+group_match_empty(const guint8 *ctrl)
+{
+    /* The high bit is set and bit 1 isn't only for CTRL_EMPTY. */
+    guint64 group = group_load(ctrl);
+    return group & ~(group << 6) & GROUP_MSBS;
+}
+
+static inline group_mask_t
+group_match_empty_or_deleted(const guint8 *ctrl)
+{
+    return group_load(ctrl) & GROUP_MSBS;
+}
+
+#define MASK_SHIFT 3
+#endif
+
+static inline guint
+group_mask_first(group_mask_t mask)
+{
+    return (guint)ws_ctz(mask) >> MASK_SHIFT;
+}
+
+#define MASK_NEXT(MASK) ((MASK) &= (MASK) - 1)
+
+static void
+wmem_map_alloc_table(wmem_map_t *map, size_t capacity)
+{
+    map->count    = 0;
+    map->deleted  = 0;
+    map->capacity = capacity;
+    map->table    = wmem_alloc_array(map->allocator, wmem_map_slot_t, CAPACITY(map));
+    map->ctrl     = (guint8 *)wmem_alloc(map->allocator, CAPACITY(map));
+    memset(map->ctrl, CTRL_EMPTY, CAPACITY(map));
+}
 
 static void
 wmem_map_init_table(wmem_map_t *map)
 {
-    map->count     = 0;
-    map->capacity  = WMEM_MAP_DEFAULT_CAPACITY;
-    map->table     = wmem_alloc0_array(map->allocator, wmem_map_item_t*, CAPACITY(map));
+    wmem_map_alloc_table(map, WMEM_MAP_DEFAULT_CAPACITY);
 }
 
 wmem_map_t *
@@ -97,7 +222,9 @@ wmem_map_new(wmem_allocator_t *allocator,
     map->master    = allocator;
     map->allocator = allocator;
     map->count = 0;
+    map->deleted = 0;
     map->table = NULL;
+    map->ctrl = NULL;
 
     return map;
 }
@@ -109,7 +236,9 @@ wmem_map_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
     wmem_map_t *map = (wmem_map_t*)user_data;
 
     map->count = 0;
+    map->deleted = 0;
     map->table = NULL;
+    map->ctrl = NULL;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(map->master, map->master_cb_id);
@@ -143,7 +272,9 @@ wmem_map_new_autoreset(wmem_allocator_t *master, wmem_allocator_t *slave,
     map->master    = master;
     map->allocator = slave;
     map->count = 0;
+    map->deleted = 0;
     map->table = NULL;
+    map->ctrl = NULL;
 
     map->master_cb_id = wmem_register_callback(master, wmem_map_destroy_cb, map);
     map->slave_cb_id  = wmem_register_callback(slave, wmem_map_reset_cb, map);
@@ -151,77 +282,141 @@ wmem_map_new_autoreset(wmem_allocator_t *master, wmem_allocator_t *slave,
     return map;
 }
 
-static inline void
+/* Returns the slot holding key, or -1. */
+static gssize
+wmem_map_find(const wmem_map_t *map, const void *key, guint64 hash)
+{
+    size_t       mask = CAPACITY(map) - 1;
+    size_t       pos  = H1(map, hash) & ~(size_t)(GROUP_WIDTH - 1);
+    size_t       step = 0;
+    guint8       h2   = H2(hash);
+    group_mask_t match;
+    size_t       slot;
+
+    for (;;) {
+        match = group_match(map->ctrl + pos, h2);
+        while (match) {
+            slot = pos + group_mask_first(match);
+            if (map->eql_func(key, map->table[slot].key)) {
+                return (gssize)slot;
+            }
+            MASK_NEXT(match);
+        }
+        if (group_match_empty(map->ctrl + pos)) {
+            return -1;
+        }
+        step += GROUP_WIDTH;
+        pos = (pos + step) & mask;
+    }
+}
+
+/* Returns the first empty or deleted slot on the key's probe sequence. There
+ * is always one, as the table is never allowed to fill up. */
+static size_t
+wmem_map_find_free(const wmem_map_t *map, guint64 hash)
+{
+    size_t       mask = CAPACITY(map) - 1;
+    size_t       pos  = H1(map, hash) & ~(size_t)(GROUP_WIDTH - 1);
+    size_t       step = 0;
+    group_mask_t match;
+
+    for (;;) {
+        match = group_match_empty_or_deleted(map->ctrl + pos);
+        if (match) {
+            return pos + group_mask_first(match);
+        }
+        step += GROUP_WIDTH;
+        pos = (pos + step) & mask;
+    }
+}
+
+/* Rebuilds the table, at double the size unless it is mostly deleted slots,
+ * which we can drop instead. */
+static void
 wmem_map_grow(wmem_map_t *map)
 {
-    wmem_map_item_t **old_table, *cur, *nxt;
-    size_t            old_cap, i;
-    guint             slot;
+    wmem_map_slot_t *old_table;
+    guint8          *old_ctrl;
+    size_t           old_cap, i, slot;
+    guint64          hash;
 
     /* store the old table and capacity */
     old_table = map->table;
+    old_ctrl  = map->ctrl;
     old_cap   = CAPACITY(map);
 
-    /* double the size (capacity is base-2 logarithm, so this just means
-     * increment it) and allocate new table */
-    map->capacity++;
-    map->table = wmem_alloc0_array(map->allocator, wmem_map_item_t*, CAPACITY(map));
+    wmem_map_alloc_table(map, map->capacity + ((map->count >= old_cap / 2) ? 1 : 0));
 
     /* copy all the elements over from the old table */
     for (i=0; i<old_cap; i++) {
-        cur = old_table[i];
-        while (cur) {
-            nxt              = cur->next;
-            slot             = HASH(map, cur->key);
-            cur->next        = map->table[slot];
-            map->table[slot] = cur;
-            cur              = nxt;
+        if (old_ctrl[i] & 0x80) {
+            continue;
         }
+        hash = wmem_map_hash(map, old_table[i].key);
+        slot = wmem_map_find_free(map, hash);
+        map->ctrl[slot]  = H2(hash);
+        map->table[slot] = old_table[i];
+        map->count++;
     }
 
     /* free the old table */
+    wmem_free(map->allocator, old_ctrl);
     wmem_free(map->allocator, old_table);
 }
 
+/* Empties a slot: see the comment at the top for which mark it gets. */
+static void
+wmem_map_clear_slot(wmem_map_t *map, size_t slot)
+{
+    size_t group = slot & ~(size_t)(GROUP_WIDTH - 1);
+
+    if (group_match_empty(map->ctrl + group)) {
+        map->ctrl[slot] = CTRL_EMPTY;
+    } else {
+        map->ctrl[slot] = CTRL_DELETED;
+        map->deleted++;
+    }
+    map->count--;
+}
+
 void *
 wmem_map_insert(wmem_map_t *map, const void *key, void *value)
 {
-    wmem_map_item_t **item;
-    void *old_val;
+    guint64 hash;
+    gssize  found;
+    size_t  slot;
+    void   *old_val;
 
     /* Make sure we have a table */
     if (map->table == NULL) {
         wmem_map_init_table(map);
     }
 
-    /* get a pointer to the slot */
-    item = &(map->table[HASH(map, key)]);
+    hash  = wmem_map_hash(map, key);
+    found = wmem_map_find(map, key, hash);
+    if (found >= 0) {
+        /* replace and return old value for this key */
+        old_val = map->table[found].value;
+        map->table[found].value = value;
+        return old_val;
+    }
 
-    /* check existing items in that slot */
-    while (*item) {
-        if (map->eql_func(key, (*item)->key)) {
-            /* replace and return old value for this key */
-            old_val = (*item)->value;
-            (*item)->value = value;
-            return old_val;
-        }
-        item = &((*item)->next);
+    /* increase size if we are over-full */
+    if (map->count + map->deleted + 1 > MAX_LOAD(map)) {
+        wmem_map_grow(map);
     }
 
     /* insert new item */
-    (*item) = wmem_new(map->allocator, wmem_map_item_t);
-
-    (*item)->key   = key;
-    (*item)->value = value;
-    (*item)->next  = NULL;
+    slot = wmem_map_find_free(map, hash);
+    if (map->ctrl[slot] == CTRL_DELETED) {
+        map->deleted--;
+    }
+    map->ctrl[slot]        = H2(hash);
+    map->table[slot].key   = key;
+    map->table[slot].value = value;
 
     map->count++;
 
-    /* increase size if we are over-full */
-    if (map->count >= CAPACITY(map)) {
-        wmem_map_grow(map);
-    }
-
     /* no previous entry, return NULL */
     return NULL;
 }
@@ -229,147 +424,100 @@ wmem_map_insert(wmem_map_t *map, const void *key, void *value)
 gboolean
 wmem_map_contains(wmem_map_t *map, const void *key)
 {
-    wmem_map_item_t *item;
-
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
     }
 
-    /* find correct slot */
-    item = map->table[HASH(map, key)];
-
-    /* scan list of items in this slot for the correct value */
-    while (item) {
-        if (map->eql_func(key, item->key)) {
-            return TRUE;
-        }
-        item = item->next;
-    }
-
-    return FALSE;
+    return wmem_map_find(map, key, wmem_map_hash(map, key)) >= 0;
 }
 
 void *
 wmem_map_lookup(wmem_map_t *map, const void *key)
 {
-    wmem_map_item_t *item;
+    gssize slot;
 
     /* Make sure we have a table */
     if (map->table == NULL) {
         return NULL;
     }
 
-    /* find correct slot */
-    item = map->table[HASH(map, key)];
-
-    /* scan list of items in this slot for the correct value */
-    while (item) {
-        if (map->eql_func(key, item->key)) {
-            return item->value;
-        }
-        item = item->next;
+    slot = wmem_map_find(map, key, wmem_map_hash(map, key));
+    if (slot < 0) {
+        return NULL;
     }
 
-    return NULL;
+    return map->table[slot].value;
 }
 
 gboolean
 wmem_map_lookup_extended(wmem_map_t *map, const void *key, const void **orig_key, void **value)
 {
-    wmem_map_item_t *item;
+    gssize slot;
 
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
     }
 
-    /* find correct slot */
-    item = map->table[HASH(map, key)];
-
-    /* scan list of items in this slot for the correct value */
-    while (item) {
-        if (map->eql_func(key, item->key)) {
-            if (orig_key) {
-                *orig_key = item->key;
-            }
-            if (value) {
-                *value = item->value;
-            }
-            return TRUE;
-        }
-        item = item->next;
+    slot = wmem_map_find(map, key, wmem_map_hash(map, key));
+    if (slot < 0) {
+        return FALSE;
     }
 
-    return FALSE;
+    if (orig_key) {
+        *orig_key = map->table[slot].key;
+    }
+    if (value) {
+        *value = map->table[slot].value;
+    }
+    return TRUE;
 }
 
 void *
 wmem_map_remove(wmem_map_t *map, const void *key)
 {
-    wmem_map_item_t **item, *tmp;
-    void *value;
+    gssize slot;
 
     /* Make sure we have a table */
     if (map->table == NULL) {
         return NULL;
     }
 
-    /* get a pointer to the slot */
-    item = &(map->table[HASH(map, key)]);
-
-    /* check the items in that slot */
-    while (*item) {
-        if (map->eql_func(key, (*item)->key)) {
-            /* found it */
-            tmp     = (*item);
-            value   = tmp->value;
-            (*item) = tmp->next;
-            wmem_free(map->allocator, tmp);
-            map->count--;
-            return value;
-        }
-        item = &((*item)->next);
+    slot = wmem_map_find(map, key, wmem_map_hash(map, key));
+    if (slot < 0) {
+        /* didn't find it */
+        return NULL;
     }
 
-    /* didn't find it */
-    return NULL;
+    wmem_map_clear_slot(map, (size_t)slot);
+    return map->table[slot].value;
 }
 
 gboolean
 wmem_map_steal(wmem_map_t *map, const void *key)
 {
-    wmem_map_item_t **item, *tmp;
+    gssize slot;
 
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
     }
 
-    /* get a pointer to the slot */
-    item = &(map->table[HASH(map, key)]);
-
-    /* check the items in that slot */
-    while (*item) {
-        if (map->eql_func(key, (*item)->key)) {
-            /* found it */
-            tmp     = (*item);
-            (*item) = tmp->next;
-            map->count--;
-            return TRUE;
-        }
-        item = &((*item)->next);
+    slot = wmem_map_find(map, key, wmem_map_hash(map, key));
+    if (slot < 0) {
+        /* didn't find it */
+        return FALSE;
     }
 
-    /* didn't find it */
-    return FALSE;
+    wmem_map_clear_slot(map, (size_t)slot);
+    return TRUE;
 }
 
 wmem_list_t*
 wmem_map_get_keys(wmem_allocator_t *list_allocator, wmem_map_t *map)
 {
     size_t capacity, i;
-    wmem_map_item_t *cur;
     wmem_list_t* list = wmem_list_new(list_allocator);
 
     if (map->table != NULL) {
@@ -377,10 +525,8 @@ wmem_map_get_keys(wmem_allocator_t *list_allocator, wmem_map_t *map)
 
         /* copy all the elements into the list over from table */
         for (i=0; i<capacity; i++) {
-            cur = map->table[i];
-            while (cur) {
-                wmem_list_prepend(list, (void*)cur->key);
-                cur = cur->next;
+            if (!(map->ctrl[i] & 0x80)) {
+                wmem_list_prepend(list, (void*)map->table[i].key);
             }
         }
     }
@@ -391,8 +537,7 @@ wmem_map_get_keys(wmem_allocator_t *list_allocator, wmem_map_t *map)
 void
 wmem_map_foreach(wmem_map_t *map, GHFunc foreach_func, gpointer user_data)
 {
-    wmem_map_item_t *cur;
-    unsigned i;
+    size_t i;
 
     /* Make sure we have a table */
     if (map->table == NULL) {
@@ -400,10 +545,8 @@ wmem_map_foreach(wmem_map_t *map, GHFunc foreach_func, gpointer user_data)
     }
 
     for (i = 0; i < CAPACITY(map); i++) {
-        cur = map->table[i];
-        while (cur) {
-            foreach_func((gpointer)cur->key, (gpointer)cur->value, user_data);
-            cur = cur->next;
+        if (!(map->ctrl[i] & 0x80)) {
+            foreach_func((gpointer)map->table[i].key, (gpointer)map->table[i].value, user_data);
         }
     }
 }
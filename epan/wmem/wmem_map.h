@@ -26,7 +26,8 @@ extern "C" {
  *
  *    A hash map implementation on top of wmem. Provides insertion, deletion and
  *    lookup in expected amortized constant time. Uses universal hashing to map
- *    keys into buckets, and provides a generic strong hash function that makes
+ *    keys into an open-addressing table, so lookups don't chase pointers, and
+ *    provides a generic strong hash function that makes
  *    it secure against algorithmic complexity attacks, and suitable for use
  *    even with untrusted data.
  *
@@ -12,6 +12,7 @@
 #include "config.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <glib.h>
 
 #include "wmem.h"
@@ -989,10 +990,110 @@ wmem_test_map(void)
     }
     g_assert(wmem_map_size(map) == CONTAINER_ITERS);
 
+    /* interleaved insertion and removal, reusing deleted slots */
+    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    g_assert(map);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        if (i >= 100) {
+            ret = wmem_map_remove(map, GINT_TO_POINTER(i - 100));
+            g_assert(ret == GINT_TO_POINTER(i - 100));
+        }
+        g_assert(wmem_map_size(map) == MIN(i + 1, 100));
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_map_lookup(map, GINT_TO_POINTER(i));
+        g_assert(ret == (i >= CONTAINER_ITERS - 100 ? GINT_TO_POINTER(i) : NULL));
+    }
+
     wmem_destroy_allocator(extra_allocator);
     wmem_destroy_allocator(allocator);
 }
 
+/* Shaped like a conversation key for two IPv4 endpoints. */
+typedef struct {
+    guint32 addr1;
+    guint32 addr2;
+    guint32 etype;
+    guint32 port1;
+    guint32 port2;
+} wmem_test_map_key_t;
+
+static guint
+wmem_test_map_key_hash(gconstpointer key)
+{
+    return wmem_strong_hash((const guint8 *)key, sizeof(wmem_test_map_key_t));
+}
+
+static gboolean
+wmem_test_map_key_equal(gconstpointer a, gconstpointer b)
+{
+    return memcmp(a, b, sizeof(wmem_test_map_key_t)) == 0;
+}
+
+/* NOTE: You have to run "wmem_test --verbose" to see results. */
+static void
+wmem_test_mapperf(void)
+{
+#define MAP_PERF_KEYS (256 * 1024)
+    wmem_allocator_t    *allocator;
+    wmem_map_t          *map;
+    wmem_test_map_key_t *keys = g_new0(wmem_test_map_key_t, MAP_PERF_KEYS);
+    guint32             *order = g_new(guint32, MAP_PERF_KEYS);
+    guint32              i, j, tmp;
+    double               start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
+    for (i = 0; i < MAP_PERF_KEYS; i++) {
+        keys[i].addr1 = 0x0a000000 | (i % 4096);
+        keys[i].addr2 = 0xc0a80000 | (i / 4096);
+        keys[i].etype = 2;
+        keys[i].port1 = 1024 + (i % 60000);
+        keys[i].port2 = 443;
+        order[i] = i;
+    }
+    /* look the keys up and remove them in random order */
+    for (i = MAP_PERF_KEYS - 1; i > 0; i--) {
+        j = (guint32)g_random_int_range(0, (gint32)i + 1);
+        tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    map = wmem_map_new(allocator, wmem_test_map_key_hash, wmem_test_map_key_equal);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < MAP_PERF_KEYS; i++) {
+        wmem_map_insert(map, &keys[i], &keys[i]);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_map_insert conversation keys: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < MAP_PERF_KEYS; i++) {
+        g_assert(wmem_map_lookup(map, &keys[order[i]]) == &keys[order[i]]);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_map_lookup conversation keys: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < MAP_PERF_KEYS; i++) {
+        g_assert(wmem_map_remove(map, &keys[order[i]]) == &keys[order[i]]);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_map_remove conversation keys: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    g_assert(wmem_map_size(map) == 0);
+
+    wmem_destroy_allocator(allocator);
+    g_free(order);
+    g_free(keys);
+}
+
 static void
 wmem_test_queue(void)
 {
@@ -1431,6 +1532,7 @@ main(int argc, char **argv)
 
     if (!g_test_perf ()) {
         g_test_add_func("/wmem/utils/stringperf", wmem_test_stringperf);
+        g_test_add_func("/wmem/datastruct/mapperf", wmem_test_mapperf);
     }
 
     g_test_add_func("/wmem/datastruct/array",  wmem_test_array);
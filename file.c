@@ -75,6 +75,7 @@ static gboolean read_record(capture_file *cf, dfilter_t *dfcode,
     epan_dissect_t *edt, column_info *cinfo, gint64 offset);
 
 static void rescan_packets(capture_file *cf, const char *action, const char *action_item, gboolean redissect);
+static void field_presence_reset(capture_file *cf);
 
 typedef enum {
   MR_NOTMATCHED,
@@ -242,7 +243,8 @@ ws_epan_new(capture_file *cf)
     ws_get_frame_ts,
     cap_file_provider_get_interface_name,
     cap_file_provider_get_interface_description,
-    cap_file_provider_get_user_comment
+    cap_file_provider_get_user_comment,
+    cap_file_provider_get_shift_offset
   };
 
   return epan_new(&cf->provider, &funcs);
@@ -401,6 +403,7 @@ cf_close(capture_file *cf)
     g_tree_destroy(cf->provider.frames_user_comments);
     cf->provider.frames_user_comments = NULL;
   }
+  field_presence_reset(cf);
   cf_unselect_packet(cf);   /* nothing to select */
   cf->first_displayed = 0;
   cf->last_displayed = 0;
@@ -1141,6 +1144,179 @@ void cf_set_rfcode(capture_file *cf, dfilter_t *rfcode)
   cf->rfcode = rfcode;
 }
 
+/*
+ * Field presence tracking.
+ *
+ * While rescanning the packet list with a display filter, we note, for
+ * each frame, which of the fields the filter can't match without are
+ * present in the frame.  A later rescan whose filter requires one of those
+ * fields can then reject the frames that don't have it without reading or
+ * dissecting them.  A field's bits are only trusted once a rescan has
+ * recorded them for every frame, and they're discarded whenever the
+ * dissection of the frames might change.
+ */
+static void
+field_presence_reset(capture_file *cf)
+{
+  g_free(cf->field_presence.bits);
+  memset(&cf->field_presence, 0, sizeof(cf->field_presence));
+}
+
+/*
+ * Fields of the frame "protocol" reflect things that change without a
+ * redissection, such as marks, comments and time references, so don't
+ * track them.
+ */
+static gboolean
+field_presence_trackable(int hfid)
+{
+  int                proto_frame = proto_get_id_by_filter_name("frame");
+  int                proto_pkt_comment = proto_get_id_by_filter_name("pkt_comment");
+  header_field_info *hfinfo;
+
+  for (hfinfo = proto_registrar_get_nth(hfid); hfinfo != NULL;
+       hfinfo = hfinfo->same_name_next) {
+    if (hfinfo->id == proto_frame || hfinfo->parent == proto_frame ||
+        hfinfo->id == proto_pkt_comment || hfinfo->parent == proto_pkt_comment)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* Returns the bit index of the field, starting to track it if necessary;
+   -1 if we can't track any more fields. */
+static int
+field_presence_index(field_presence_t *fp, int hfid)
+{
+  int i;
+
+  for (i = 0; i < fp->num_fields; i++) {
+    if (fp->hfids[i] == hfid)
+      return i;
+  }
+  if (fp->num_fields == FIELD_PRESENCE_MAX_FIELDS)
+    return -1;
+  fp->hfids[fp->num_fields] = hfid;
+  return fp->num_fields++;
+}
+
+static void
+field_presence_begin_pass(capture_file *cf, dfilter_t *dfcode)
+{
+  field_presence_t  *fp = &cf->field_presence;
+  const int         *required;
+  int                num_required;
+  int                i, bit;
+  header_field_info *hfinfo;
+  guint16            mask;
+  gboolean           valid;
+
+  if (fp->bits_len != cf->count) {
+    /* Frames have been added since the bits were recorded. */
+    fp->num_valid = 0;
+  }
+  fp->num_fields = fp->num_valid;
+  fp->num_reject_masks = 0;
+  fp->recording = FALSE;
+  fp->complete = TRUE;
+
+  if (dfcode == NULL)
+    return;
+
+  num_required = dfilter_required_fields(dfcode, &required);
+  for (i = 0; i < num_required; i++) {
+    if (!field_presence_trackable(required[i]))
+      continue;
+
+    /* A frame lacking the field lacks all fields with the same name. */
+    mask = 0;
+    valid = TRUE;
+    for (hfinfo = proto_registrar_get_nth(required[i]); hfinfo != NULL;
+         hfinfo = hfinfo->same_name_next) {
+      bit = field_presence_index(fp, hfinfo->id);
+      if (bit == -1) {
+        mask = 0;
+        break;
+      }
+      if (bit >= fp->num_valid)
+        valid = FALSE;
+      mask |= (guint16)(1 << bit);
+    }
+    if (mask != 0 && valid)
+      fp->reject_masks[fp->num_reject_masks++] = mask;
+  }
+
+  if (fp->num_fields > fp->num_valid) {
+    /* We have new fields to learn about. */
+    fp->recording = TRUE;
+    if (fp->bits_len < cf->count) {
+      fp->bits = g_renew(guint16, fp->bits, cf->count);
+      memset(fp->bits + fp->bits_len, 0,
+             (cf->count - fp->bits_len) * sizeof(guint16));
+      fp->bits_len = cf->count;
+    }
+  }
+}
+
+static void
+field_presence_prime(capture_file *cf, epan_dissect_t *edt)
+{
+  field_presence_t *fp = &cf->field_presence;
+  int               i;
+
+  for (i = fp->num_valid; i < fp->num_fields; i++)
+    epan_dissect_prime_with_hfid(edt, fp->hfids[i]);
+}
+
+static void
+field_presence_record(capture_file *cf, frame_data *fdata, epan_dissect_t *edt)
+{
+  field_presence_t *fp = &cf->field_presence;
+  guint16           bits;
+  int               i;
+
+  if (edt == NULL || edt->tree == NULL || fdata->num > fp->bits_len) {
+    fp->complete = FALSE;
+    return;
+  }
+
+  bits = (guint16)(fp->bits[fdata->num - 1] & ((1 << fp->num_valid) - 1));
+  for (i = fp->num_valid; i < fp->num_fields; i++) {
+    if (proto_check_for_protocol_or_field(edt->tree, fp->hfids[i]))
+      bits |= (guint16)(1 << i);
+  }
+  fp->bits[fdata->num - 1] = bits;
+}
+
+/* Returns TRUE if we know the frame can't pass the display filter. */
+static gboolean
+field_presence_rejects(capture_file *cf, frame_data *fdata)
+{
+  field_presence_t *fp = &cf->field_presence;
+  int               i;
+
+  if (fp->recording || fdata->num > fp->bits_len)
+    return FALSE;
+
+  for (i = 0; i < fp->num_reject_masks; i++) {
+    if ((fp->bits[fdata->num - 1] & fp->reject_masks[i]) == 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static void
+field_presence_end_pass(capture_file *cf, gboolean finished)
+{
+  field_presence_t *fp = &cf->field_presence;
+
+  if (fp->recording && fp->complete && finished && fp->bits_len == cf->count)
+    fp->num_valid = fp->num_fields;
+  fp->num_fields = fp->num_valid;
+  fp->num_reject_masks = 0;
+  fp->recording = FALSE;
+}
+
 static void
 add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
     epan_dissect_t *edt, dfilter_t *dfcode, column_info *cinfo,
@@ -1150,33 +1326,46 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
                                 &cf->provider.ref, cf->provider.prev_dis);
   cf->provider.prev_cap = fdata;
 
-  if (dfcode != NULL) {
-      epan_dissect_prime_with_dfilter(edt, dfcode);
-  }
+  /* If we weren't handed an epan_dissect_t, the caller has determined
+     that nothing needs the dissection (no display filter, no taps), or
+     that the frame can't pass the display filter; just do the
+     bookkeeping for the frame. */
+  if (edt != NULL) {
+    if (dfcode != NULL) {
+        epan_dissect_prime_with_dfilter(edt, dfcode);
+    }
+    if (cf->field_presence.recording) {
+      field_presence_prime(cf, edt);
+    }
 #if 0
-  /* Prepare coloring rules, this ensures that display filter rules containing
-   * frame.color_rule references are still processed.
-   * TODO: actually detect that situation or maybe apply other optimizations? */
-  if (edt->tree && color_filters_used()) {
-    color_filters_prime_edt(edt);
-    fdata->need_colorize = 1;
-  }
+    /* Prepare coloring rules, this ensures that display filter rules containing
+     * frame.color_rule references are still processed.
+     * TODO: actually detect that situation or maybe apply other optimizations? */
+    if (edt->tree && color_filters_used()) {
+      color_filters_prime_edt(edt);
+      fdata->need_colorize = 1;
+    }
 #endif
 
-  if (!fdata->visited) {
-    /* This is the first pass, so prime the epan_dissect_t with the
-       hfids postdissectors want on the first pass. */
-    prime_epan_dissect_with_postdissector_wanted_hfids(edt);
+    if (!fdata->visited) {
+      /* This is the first pass, so prime the epan_dissect_t with the
+         hfids postdissectors want on the first pass. */
+      prime_epan_dissect_with_postdissector_wanted_hfids(edt);
+    }
+
+    /* Dissect the frame. */
+    epan_dissect_run_with_taps(edt, cf->cd_t, rec,
+                               frame_tvbuff_new(&cf->provider, fdata, buf),
+                               fdata, cinfo);
   }
 
-  /* Dissect the frame. */
-  epan_dissect_run_with_taps(edt, cf->cd_t, rec,
-                             frame_tvbuff_new(&cf->provider, fdata, buf),
-                             fdata, cinfo);
+  if (cf->field_presence.recording) {
+    field_presence_record(cf, fdata, edt);
+  }
 
   /* If we don't have a display filter, set "passed_dfilter" to 1. */
   if (dfcode != NULL) {
-    fdata->passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
+    fdata->passed_dfilter = (edt != NULL && dfilter_apply_edt(dfcode, edt)) ? 1 : 0;
 
     if (fdata->passed_dfilter) {
       /* This frame passed the display filter but it may depend on other
@@ -1209,7 +1398,8 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
     cf->last_displayed = fdata->num;
   }
 
-  epan_dissect_reset(edt);
+  if (edt != NULL)
+    epan_dissect_reset(edt);
 }
 
 /*
@@ -1615,6 +1805,9 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   gboolean    compiled;
   guint32     frames_count;
   gboolean    queued_rescan_type = RESCAN_NONE;
+  gboolean    dissect_frames;
+  gboolean    skip_rejected;
+  gboolean    dissect_frame;
 
   /* Rescan in progress, clear pending actions. */
   cf->redissection_queued = RESCAN_NONE;
@@ -1697,8 +1890,28 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
      * packet list store. */
     packet_list_clear();
     add_to_packet_list = TRUE;
+
+    /* The frames may not dissect the way they did before. */
+    field_presence_reset(cf);
   }
 
+  /*
+   * If we aren't redissecting, and have neither a display filter nor
+   * any tap listeners, every frame will be displayed and nothing will
+   * look at the dissection, so we don't have to read and dissect the
+   * frames at all.  That's the case when a display filter is cleared,
+   * which otherwise costs as much as applying one.
+   */
+  dissect_frames = redissect || dfcode != NULL || tap_listeners_require_dissection();
+
+  /*
+   * If we aren't redissecting and no tap listener needs to see every
+   * frame, frames that we know from an earlier rescan lack a field the
+   * display filter requires needn't be read or dissected either.
+   */
+  field_presence_begin_pass(cf, redissect ? NULL : dfcode);
+  skip_rejected = !redissect && !tap_listeners_require_dissection();
+
   /* We don't yet know which will be the first and last frames displayed. */
   cf->first_displayed = 0;
   cf->last_displayed = 0;
@@ -1825,7 +2038,10 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     /* Frame dependencies from the previous dissection/filtering are no longer valid. */
     fdata->dependent_of_displayed = 0;
 
-    if (!cf_read_record(cf, fdata))
+    dissect_frame = dissect_frames &&
+                    !(skip_rejected && field_presence_rejects(cf, fdata));
+
+    if (dissect_frame && !cf_read_record(cf, fdata))
       break; /* error reading the frame */
 
     /* If the previous frame is displayed, and we haven't yet seen the
@@ -1836,7 +2052,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
       preceding_frame = prev_frame;
     }
 
-    add_packet_to_packet_list(fdata, cf, &edt, dfcode,
+    add_packet_to_packet_list(fdata, cf, dissect_frame ? &edt : NULL, dfcode,
                                     cinfo, &cf->rec,
                                     ws_buffer_start_ptr(&cf->buf),
                                     add_to_packet_list);
@@ -1863,6 +2079,8 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
 
   epan_dissect_cleanup(&edt);
 
+  field_presence_end_pass(cf, framenum > frames_count);
+
   /* We are done redissecting the packet list. */
   cf->redissecting = FALSE;
 
@@ -3869,6 +4087,8 @@ cf_ignore_frame(capture_file *cf, frame_data *frame)
     frame->ignored = TRUE;
     if (cf->count > cf->ignored_count)
       cf->ignored_count++;
+    /* The frame no longer dissects the way it did. */
+    field_presence_reset(cf);
   }
 }
 
@@ -3882,6 +4102,8 @@ cf_unignore_frame(capture_file *cf, frame_data *frame)
     frame->ignored = FALSE;
     if (cf->ignored_count > 0)
       cf->ignored_count--;
+    /* The frame no longer dissects the way it did. */
+    field_presence_reset(cf);
   }
 }
 
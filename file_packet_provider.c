@@ -79,6 +79,15 @@ cap_file_provider_get_user_comment(struct packet_provider_data *prov, const fram
   return NULL;
 }
 
+void
+cap_file_provider_get_shift_offset(struct packet_provider_data *prov, guint32 frame_num, nstime_t *offset)
+{
+  if (prov->frames)
+    frame_data_sequence_get_shift_offset(prov->frames, frame_num, offset);
+  else
+    nstime_set_zero(offset);
+}
+
 void
 cap_file_provider_set_user_comment(struct packet_provider_data *prov, frame_data *fd, const char *new_comment)
 {
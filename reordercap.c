@@ -26,6 +26,7 @@
 #endif
 
 #include <ui/cmdarg_err.h>
+#include <ui/clopts_common.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
 #include <wsutil/privileges.h>
@@ -54,6 +55,12 @@ print_usage(FILE *output)
     fprintf(output, "\n");
     fprintf(output, "Options:\n");
     fprintf(output, "  -n        don't write to output file if the input file is ordered.\n");
+    fprintf(output, "  -w <depth>\n");
+    fprintf(output, "            reorder within a sliding window of <depth> frames,\n");
+    fprintf(output, "            writing the output while the input is read.\n");
+    fprintf(output, "  -m <frames>\n");
+    fprintf(output, "            sort runs of <frames> frames into temporary files\n");
+    fprintf(output, "            and merge them, bounding memory use.\n");
     fprintf(output, "  -h        display this help and exit.\n");
 }
 
@@ -66,6 +73,31 @@ typedef struct FrameRecord_t {
 } FrameRecord_t;
 
 
+/* A frame read sequentially and kept in memory, with its data */
+typedef struct BufferedFrame_t {
+    wtap_rec     rec;
+    guint8      *data;
+    guint        num;
+} BufferedFrame_t;
+
+/* Binary min-heap of pointers, ordered by cmp */
+typedef struct FrameHeap_t {
+    GPtrArray   *items;
+    GCompareFunc cmp;
+} FrameHeap_t;
+
+/* The most sorted runs merged at once; more runs are merged in several
+   passes, so as not to run out of file descriptors */
+#define MAX_MERGE_FAN_IN 64
+
+/* A temporary file holding a sorted run of frames */
+typedef struct SortRun_t {
+    char        *filename;
+    wtap        *wth;
+    guint        index;
+} SortRun_t;
+
+
 /**************************************************/
 /* Debugging only                                 */
 
@@ -135,6 +167,509 @@ frames_compare(gconstpointer a, gconstpointer b)
     return nstime_cmp(time1, time2);
 }
 
+/* Length of the data that goes with a record */
+static guint32
+rec_data_length(const wtap_rec *rec)
+{
+    switch (rec->rec_type) {
+
+    case REC_TYPE_PACKET:
+        return rec->rec_header.packet_header.caplen;
+
+    case REC_TYPE_FT_SPECIFIC_EVENT:
+    case REC_TYPE_FT_SPECIFIC_REPORT:
+        return rec->rec_header.ft_specific_header.record_len;
+
+    case REC_TYPE_SYSCALL:
+        return rec->rec_header.syscall_header.event_filelen;
+    }
+    return 0;
+}
+
+/* Copy the record wtap_read() just returned, as it will be overwritten */
+static BufferedFrame_t *
+buffered_frame_new(wtap *wth, guint num)
+{
+    const wtap_rec  *rec = wtap_get_rec(wth);
+    BufferedFrame_t *frame = g_new(BufferedFrame_t, 1);
+
+    frame->rec = *rec;
+    if (!(rec->presence_flags & WTAP_HAS_TS)) {
+        nstime_set_unset(&frame->rec.ts);
+    }
+    frame->rec.opt_comment = g_strdup(rec->opt_comment);
+    /* The options buffer is only used while reading */
+    ws_buffer_init(&frame->rec.options_buf, 0);
+    frame->data = (guint8 *)g_memdup(wtap_get_buf_ptr(wth), rec_data_length(rec));
+    frame->num = num;
+    return frame;
+}
+
+static void
+buffered_frame_free(BufferedFrame_t *frame)
+{
+    wtap_rec_cleanup(&frame->rec);
+    g_free(frame->data);
+    g_free(frame);
+}
+
+static gboolean
+buffered_frame_write(BufferedFrame_t *frame, wtap *wth, wtap_dumper *pdh,
+                     const char *infile, const char *outfile)
+{
+    int    err;
+    gchar  *err_info;
+
+    if (!wtap_dump(pdh, &frame->rec, frame->data, &err, &err_info)) {
+        cfile_write_failure_message("reordercap", infile, outfile, err,
+                                    err_info, frame->num,
+                                    wtap_file_type_subtype(wth));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Order buffered frames by timestamp, and by frame number on equal
+   timestamps so that equal frames keep their original order. */
+static gint
+buffered_frames_compare(gconstpointer a, gconstpointer b)
+{
+    const BufferedFrame_t *frame1 = (const BufferedFrame_t *) a;
+    const BufferedFrame_t *frame2 = (const BufferedFrame_t *) b;
+    int cmp;
+
+    cmp = nstime_cmp(&frame1->rec.ts, &frame2->rec.ts);
+    if (cmp != 0)
+        return cmp;
+    return (frame1->num > frame2->num) - (frame1->num < frame2->num);
+}
+
+static gint
+buffered_frames_sort_compare(gconstpointer a, gconstpointer b)
+{
+    return buffered_frames_compare(*(const BufferedFrame_t *const *) a,
+                                   *(const BufferedFrame_t *const *) b);
+}
+
+/* Order sorted runs by their current frame; earlier runs hold earlier
+   frames, so they win ties. */
+static gint
+sort_runs_compare(gconstpointer a, gconstpointer b)
+{
+    const SortRun_t *run1 = (const SortRun_t *) a;
+    const SortRun_t *run2 = (const SortRun_t *) b;
+    const wtap_rec  *rec1 = wtap_get_rec(run1->wth);
+    const wtap_rec  *rec2 = wtap_get_rec(run2->wth);
+    nstime_t         time1, time2;
+    int              cmp;
+
+    time1 = rec1->ts;
+    if (!(rec1->presence_flags & WTAP_HAS_TS))
+        nstime_set_unset(&time1);
+    time2 = rec2->ts;
+    if (!(rec2->presence_flags & WTAP_HAS_TS))
+        nstime_set_unset(&time2);
+
+    cmp = nstime_cmp(&time1, &time2);
+    if (cmp != 0)
+        return cmp;
+    return (run1->index > run2->index) - (run1->index < run2->index);
+}
+
+static void
+frame_heap_push(FrameHeap_t *heap, gpointer item)
+{
+    guint pos, parent;
+
+    g_ptr_array_add(heap->items, item);
+    pos = heap->items->len - 1;
+    while (pos > 0) {
+        parent = (pos - 1) / 2;
+        if (heap->cmp(item, heap->items->pdata[parent]) >= 0)
+            break;
+        heap->items->pdata[pos] = heap->items->pdata[parent];
+        pos = parent;
+    }
+    heap->items->pdata[pos] = item;
+}
+
+/* Restore the heap after the top item was replaced or changed */
+static void
+frame_heap_sift_down(FrameHeap_t *heap)
+{
+    gpointer item = heap->items->pdata[0];
+    guint    len = heap->items->len;
+    guint    pos = 0, child;
+
+    for (;;) {
+        child = 2 * pos + 1;
+        if (child >= len)
+            break;
+        if (child + 1 < len &&
+            heap->cmp(heap->items->pdata[child + 1], heap->items->pdata[child]) < 0)
+            child++;
+        if (heap->cmp(heap->items->pdata[child], item) >= 0)
+            break;
+        heap->items->pdata[pos] = heap->items->pdata[child];
+        pos = child;
+    }
+    heap->items->pdata[pos] = item;
+}
+
+static gpointer
+frame_heap_pop(FrameHeap_t *heap)
+{
+    gpointer top;
+
+    if (heap->items->len == 0)
+        return NULL;
+
+    top = heap->items->pdata[0];
+    heap->items->pdata[0] = heap->items->pdata[heap->items->len - 1];
+    g_ptr_array_set_size(heap->items, heap->items->len - 1);
+    if (heap->items->len > 0)
+        frame_heap_sift_down(heap);
+    return top;
+}
+
+/*
+ * Bounded-window mode: keep the last <depth> frames in a heap and write
+ * out the earliest one whenever the window is full.  Memory use is
+ * bounded by the window; a frame that is further out of place than the
+ * window allows is written late, and counted.  Returns FALSE if the
+ * output couldn't be written.
+ */
+static gboolean
+reorder_window(wtap *wth, wtap_dumper *pdh, guint depth,
+               const char *infile, const char *outfile,
+               guint *frame_count, guint *wrong_order_count)
+{
+    FrameHeap_t      heap;
+    BufferedFrame_t *frame;
+    nstime_t         prev_time, last_written;
+    gint64           data_offset;
+    int              err;
+    gchar           *err_info;
+    guint            late_count = 0;
+    gboolean         ok = TRUE;
+
+    heap.items = g_ptr_array_new();
+    heap.cmp = buffered_frames_compare;
+    nstime_set_unset(&prev_time);
+    nstime_set_unset(&last_written);
+
+    while (ok && wtap_read(wth, &err, &err_info, &data_offset)) {
+        frame = buffered_frame_new(wth, ++(*frame_count));
+
+        if (*frame_count > 1 && nstime_cmp(&frame->rec.ts, &prev_time) < 0) {
+            (*wrong_order_count)++;
+        }
+        prev_time = frame->rec.ts;
+        if (nstime_cmp(&frame->rec.ts, &last_written) < 0) {
+            late_count++;
+        }
+
+        frame_heap_push(&heap, frame);
+        if (heap.items->len > depth) {
+            frame = (BufferedFrame_t *)frame_heap_pop(&heap);
+            last_written = frame->rec.ts;
+            ok = buffered_frame_write(frame, wth, pdh, infile, outfile);
+            buffered_frame_free(frame);
+        }
+    }
+    if (ok && err != 0) {
+        /* Print a message noting that the read failed somewhere along the line. */
+        cfile_read_failure_message("reordercap", infile, err, err_info);
+    }
+
+    while ((frame = (BufferedFrame_t *)frame_heap_pop(&heap)) != NULL) {
+        if (ok)
+            ok = buffered_frame_write(frame, wth, pdh, infile, outfile);
+        buffered_frame_free(frame);
+    }
+    g_ptr_array_free(heap.items, TRUE);
+
+    if (ok && late_count > 0) {
+        fprintf(stderr,
+                "reordercap: %u frames were out of order by more than the window of %u frames;"
+                " the output is not completely in order.\n",
+                late_count, depth);
+    }
+    return ok;
+}
+
+static void
+sort_run_free(SortRun_t *run)
+{
+    if (run->wth)
+        wtap_close(run->wth);
+    if (run->filename)
+        ws_unlink(run->filename);
+    g_free(run->filename);
+    g_free(run);
+}
+
+/* Create the temporary file for a sorted run; NULL if it can't be */
+static SortRun_t *
+sort_run_open(wtap *wth, guint index, wtap_dump_params *params,
+              wtap_dumper **run_pdh)
+{
+    SortRun_t         *run = g_new0(SortRun_t, 1);
+    int                err;
+
+    wtap_dump_params_init(params, wth);
+    *run_pdh = wtap_dump_open_tempfile(&run->filename, "reordercap",
+                                       wtap_file_type_subtype(wth),
+                                       WTAP_UNCOMPRESSED, params, &err);
+    g_free(params->idb_inf);
+    params->idb_inf = NULL;
+    if (*run_pdh == NULL) {
+        cfile_dump_open_failure_message("reordercap", run->filename ? run->filename : "temporary file",
+                                        err, wtap_file_type_subtype(wth));
+        sort_run_free(run);
+        return NULL;
+    }
+
+    run->index = index;
+    return run;
+}
+
+static gboolean
+sort_run_close(SortRun_t *run, wtap_dump_params *params, wtap_dumper *run_pdh)
+{
+    int                err;
+    gboolean           ok = TRUE;
+
+    if (!wtap_dump_close(run_pdh, &err)) {
+        cfile_close_failure_message(run->filename, err);
+        ok = FALSE;
+    }
+    wtap_dump_params_cleanup(params);
+    return ok;
+}
+
+/* Write a sorted run of buffered frames to a temporary file; NULL, with
+   the file removed, if that fails */
+static SortRun_t *
+sort_run_write(GPtrArray *frames, wtap *wth, const char *infile, guint index)
+{
+    SortRun_t         *run;
+    wtap_dump_params   params;
+    wtap_dumper       *run_pdh;
+    gboolean           ok = TRUE;
+    guint              i;
+
+    run = sort_run_open(wth, index, &params, &run_pdh);
+    if (run == NULL)
+        return NULL;
+    for (i = 0; ok && i < frames->len; i++) {
+        ok = buffered_frame_write((BufferedFrame_t *)frames->pdata[i], wth, run_pdh,
+                                  infile, run->filename);
+    }
+    if (!sort_run_close(run, &params, run_pdh) || !ok) {
+        sort_run_free(run);
+        return NULL;
+    }
+
+    return run;
+}
+
+/*
+ * Merge <count> runs, starting with runs[first], into pdh, reading each
+ * one sequentially.  The merged runs are freed, and their temporary
+ * files removed.  If that fails, FALSE is returned and the runs are left
+ * for the caller to free.
+ */
+static gboolean
+sort_runs_merge(GPtrArray *runs, guint first, guint count, wtap *wth,
+                wtap_dumper *pdh, const char *infile, const char *outfile)
+{
+    FrameHeap_t      heap;
+    SortRun_t       *run;
+    gint64           data_offset;
+    int              err;
+    gchar           *err_info;
+    guint            i;
+
+    heap.items = g_ptr_array_new();
+    heap.cmp = sort_runs_compare;
+    for (i = first; i < first + count; i++) {
+        run = (SortRun_t *)runs->pdata[i];
+        run->wth = wtap_open_offline(run->filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+        if (run->wth == NULL) {
+            cfile_open_failure_message("reordercap", run->filename, err, err_info);
+            goto fail;
+        }
+        if (wtap_read(run->wth, &err, &err_info, &data_offset)) {
+            frame_heap_push(&heap, run);
+        } else if (err != 0) {
+            cfile_read_failure_message("reordercap", run->filename, err, err_info);
+            goto fail;
+        }
+    }
+
+    while (heap.items->len > 0) {
+        run = (SortRun_t *)heap.items->pdata[0];
+        if (!wtap_dump(pdh, wtap_get_rec(run->wth), wtap_get_buf_ptr(run->wth), &err, &err_info)) {
+            cfile_write_failure_message("reordercap", infile, outfile, err,
+                                        err_info, 0,
+                                        wtap_file_type_subtype(wth));
+            goto fail;
+        }
+        if (wtap_read(run->wth, &err, &err_info, &data_offset)) {
+            frame_heap_sift_down(&heap);
+        } else {
+            if (err != 0) {
+                cfile_read_failure_message("reordercap", run->filename, err, err_info);
+                goto fail;
+            }
+            frame_heap_pop(&heap);
+        }
+    }
+    g_ptr_array_free(heap.items, TRUE);
+
+    for (i = first; i < first + count; i++) {
+        sort_run_free((SortRun_t *)runs->pdata[i]);
+        runs->pdata[i] = NULL;
+    }
+    return TRUE;
+
+fail:
+    g_ptr_array_free(heap.items, TRUE);
+    return FALSE;
+}
+
+/*
+ * External-sort mode: sort the input in runs of at most <run_size>
+ * frames, write each run to a temporary file, then merge the runs.
+ * Only one run is ever held in memory, and every file is read
+ * sequentially.  If the whole input fits in one run, it's written
+ * directly.  If there are more than MAX_MERGE_FAN_IN runs, groups of
+ * consecutive runs are first merged into longer temporary runs, which
+ * keeps frames with equal time stamps in their original order.  Returns
+ * FALSE if that fails; the temporary files are removed either way.
+ */
+static gboolean
+reorder_external(wtap *wth, wtap_dumper *pdh, guint run_size,
+                 gboolean write_output_regardless,
+                 const char *infile, const char *outfile,
+                 guint *frame_count, guint *wrong_order_count)
+{
+    GPtrArray       *frames;
+    GPtrArray       *runs;
+    GPtrArray       *merged = NULL;
+    BufferedFrame_t *frame;
+    SortRun_t       *run;
+    wtap_dump_params params;
+    wtap_dumper     *run_pdh;
+    nstime_t         prev_time;
+    gint64           data_offset;
+    int              err;
+    gchar           *err_info;
+    gboolean         at_eof = FALSE;
+    gboolean         ok = TRUE;
+    guint            i, first, count;
+
+    frames = g_ptr_array_new();
+    runs = g_ptr_array_new();
+    nstime_set_unset(&prev_time);
+
+    while (!at_eof) {
+        if (wtap_read(wth, &err, &err_info, &data_offset)) {
+            frame = buffered_frame_new(wth, ++(*frame_count));
+            if (*frame_count > 1 && nstime_cmp(&frame->rec.ts, &prev_time) < 0) {
+                (*wrong_order_count)++;
+            }
+            prev_time = frame->rec.ts;
+            g_ptr_array_add(frames, frame);
+            if (frames->len < run_size)
+                continue;
+        } else {
+            if (err != 0) {
+                /* Print a message noting that the read failed somewhere along the line. */
+                cfile_read_failure_message("reordercap", infile, err, err_info);
+            }
+            at_eof = TRUE;
+            if (runs->len == 0)
+                break;  /* everything fits in memory */
+        }
+
+        if (frames->len > 0) {
+            g_ptr_array_sort(frames, buffered_frames_sort_compare);
+            run = sort_run_write(frames, wth, infile, runs->len);
+            if (run == NULL) {
+                ok = FALSE;
+                goto clean_up;
+            }
+            g_ptr_array_add(runs, run);
+            for (i = 0; i < frames->len; i++) {
+                buffered_frame_free((BufferedFrame_t *)frames->pdata[i]);
+            }
+            g_ptr_array_set_size(frames, 0);
+        }
+    }
+
+    if (!write_output_regardless && *wrong_order_count == 0) {
+        /* Nothing to write; just clean up */
+    } else if (runs->len == 0) {
+        g_ptr_array_sort(frames, buffered_frames_sort_compare);
+        for (i = 0; ok && i < frames->len; i++) {
+            ok = buffered_frame_write((BufferedFrame_t *)frames->pdata[i], wth, pdh,
+                                      infile, outfile);
+        }
+    } else {
+        while (runs->len > MAX_MERGE_FAN_IN) {
+            merged = g_ptr_array_new();
+            for (first = 0; first < runs->len; first += count) {
+                count = MIN(MAX_MERGE_FAN_IN, runs->len - first);
+                if (count == 1) {
+                    /* Nothing to merge it with; carry it over */
+                    run = (SortRun_t *)runs->pdata[first];
+                    runs->pdata[first] = NULL;
+                    run->index = merged->len;
+                    g_ptr_array_add(merged, run);
+                    continue;
+                }
+                run = sort_run_open(wth, merged->len, &params, &run_pdh);
+                if (run == NULL) {
+                    ok = FALSE;
+                    goto clean_up;
+                }
+                /* Added before it's complete, so that it's removed on failure */
+                g_ptr_array_add(merged, run);
+                ok = sort_runs_merge(runs, first, count, wth, run_pdh,
+                                     infile, run->filename);
+                if (!sort_run_close(run, &params, run_pdh))
+                    ok = FALSE;
+                if (!ok)
+                    goto clean_up;
+            }
+            g_ptr_array_free(runs, TRUE);
+            runs = merged;
+            merged = NULL;
+        }
+        ok = sort_runs_merge(runs, 0, runs->len, wth, pdh, infile, outfile);
+    }
+
+clean_up:
+    for (i = 0; i < frames->len; i++) {
+        buffered_frame_free((BufferedFrame_t *)frames->pdata[i]);
+    }
+    g_ptr_array_free(frames, TRUE);
+    for (i = 0; i < runs->len; i++) {
+        if (runs->pdata[i] != NULL)
+            sort_run_free((SortRun_t *)runs->pdata[i]);
+    }
+    g_ptr_array_free(runs, TRUE);
+    if (merged != NULL) {
+        for (i = 0; i < merged->len; i++) {
+            sort_run_free((SortRun_t *)merged->pdata[i]);
+        }
+        g_ptr_array_free(merged, TRUE);
+    }
+    return ok;
+}
+
 /*
  * General errors and warnings are reported with an console message
  * in reordercap.
@@ -174,8 +709,12 @@ main(int argc, char *argv[])
     const wtap_rec *rec;
     guint wrong_order_count = 0;
     gboolean write_output_regardless = TRUE;
+    guint window_depth = 0;
+    guint run_size = 0;
+    guint frame_count = 0;
     guint i;
     wtap_dump_params params;
+    gboolean ok;
     int                          ret = EXIT_SUCCESS;
 
     GPtrArray *frames;
@@ -219,11 +758,17 @@ main(int argc, char *argv[])
     wtap_init(TRUE);
 
     /* Process the options first */
-    while ((opt = getopt_long(argc, argv, "hnv", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "hm:nvw:", long_options, NULL)) != -1) {
         switch (opt) {
             case 'n':
                 write_output_regardless = FALSE;
                 break;
+            case 'm':
+                run_size = get_positive_int(optarg, "run size");
+                break;
+            case 'w':
+                window_depth = get_positive_int(optarg, "window depth");
+                break;
             case 'h':
                 show_help_header("Reorder timestamps of input file frames into output file.");
                 print_usage(stdout);
@@ -238,6 +783,18 @@ main(int argc, char *argv[])
         }
     }
 
+    if (window_depth != 0 && run_size != 0) {
+        cmdarg_err("-w and -m can't be used together.");
+        ret = INVALID_OPTION;
+        goto clean_exit;
+    }
+    if (window_depth != 0 && !write_output_regardless) {
+        /* The output is written while the input is still being read. */
+        cmdarg_err("-n can't be used with -w.");
+        ret = INVALID_OPTION;
+        goto clean_exit;
+    }
+
     /* Remaining args are file names */
     file_count = argc - optind;
     if (file_count == 2) {
@@ -280,6 +837,26 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    if (window_depth != 0 || run_size != 0) {
+        /* Read the input sequentially, without remembering every frame */
+        if (window_depth != 0) {
+            ok = reorder_window(wth, pdh, window_depth, infile, outfile,
+                                &frame_count, &wrong_order_count);
+        } else {
+            ok = reorder_external(wth, pdh, run_size, write_output_regardless,
+                                  infile, outfile, &frame_count, &wrong_order_count);
+        }
+        if (!ok) {
+            ret = OUTPUT_FILE_ERROR;
+            goto close_output;
+        }
+        printf("%u frames, %u out of order\n", frame_count, wrong_order_count);
+        if (!write_output_regardless && (wrong_order_count == 0)) {
+            printf("Not writing output file because input file is already in order.\n");
+        }
+        goto close_output;
+    }
+
     /* Allocate the array of frame pointers. */
     frames = g_ptr_array_new();
 
@@ -339,6 +916,7 @@ main(int argc, char *argv[])
     /* Free the whole array */
     g_ptr_array_free(frames, TRUE);
 
+close_output:
     /* Close outfile */
     if (!wtap_dump_close(pdh, &err)) {
         cfile_close_failure_message(outfile, err);
@@ -74,6 +74,12 @@ capture_file cfile;
 static guint32 cum_bytes;
 static frame_data ref_frame;
 
+/* Identity, size and modification time of the loaded capture file, as of
+   when it was opened; see sharkd_cf_is_loaded(). */
+static gboolean loaded_file_have_stat;
+static gboolean loaded_file_valid;
+static ws_statb64 loaded_file_stat;
+
 static void failure_warning_message(const char *msg_format, va_list ap);
 static void open_failure_message(const char *filename, int err,
     gboolean for_writing);
@@ -392,6 +398,9 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   wtap  *wth;
   gchar *err_info;
 
+  loaded_file_valid = FALSE;
+  loaded_file_have_stat = (ws_stat64(fname, &loaded_file_stat) == 0);
+
   wth = wtap_open_offline(fname, type, err, &err_info, TRUE);
   if (wth == NULL)
     goto fail;
@@ -502,7 +511,66 @@ sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *
 int
 sharkd_load_cap_file(void)
 {
-  return load_cap_file(&cfile, 0, 0);
+  int err;
+
+  err = load_cap_file(&cfile, 0, 0);
+  loaded_file_valid = (err == 0 && loaded_file_have_stat);
+  return err;
+}
+
+/*
+ * Returns TRUE if fname names the capture file that is already loaded and
+ * it hasn't changed on disk since it was opened, in which case the frames
+ * and dissection state we have can be used as they are instead of reading
+ * and dissecting the whole file again.  A file with unsaved changes, such
+ * as comments, isn't reused; loading it again discards them.
+ */
+gboolean
+sharkd_cf_is_loaded(const char *fname)
+{
+  ws_statb64 st;
+
+  if (!loaded_file_valid || cfile.unsaved_changes || cfile.filename == NULL ||
+      strcmp(cfile.filename, fname) != 0)
+    return FALSE;
+
+  if (ws_stat64(fname, &st) != 0)
+    return FALSE;
+
+  return st.st_dev == loaded_file_stat.st_dev &&
+         st.st_ino == loaded_file_stat.st_ino &&
+         st.st_size == loaded_file_stat.st_size &&
+         st.st_mtime == loaded_file_stat.st_mtime;
+}
+
+/*
+ * Forget that the loaded capture file is reusable, e.g. because the
+ * preferences it was dissected with have changed; the next "load" of it
+ * reads and dissects it again.
+ */
+void
+sharkd_cf_invalidate_loaded(void)
+{
+  loaded_file_valid = FALSE;
+}
+
+/*
+ * Give a process forked after the capture file was loaded its own
+ * descriptor for the file; the inherited one shares its file position
+ * with every other process that has it.
+ */
+int
+sharkd_cf_reopen(void)
+{
+  int err = 0;
+
+  if (cfile.provider.wth == NULL)
+    return 0;
+
+  wtap_fdclose(cfile.provider.wth);
+  if (!wtap_fdreopen(cfile.provider.wth, cfile.filename, &err))
+    loaded_file_valid = FALSE;
+  return err;
 }
 
 frame_data *
@@ -787,6 +855,7 @@ int
 sharkd_set_user_comment(frame_data *fd, const gchar *new_comment)
 {
   cap_file_provider_set_user_comment(&cfile.provider, fd, new_comment);
+  cfile.unsaved_changes = TRUE;
   return 0;
 }
 
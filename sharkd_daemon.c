@@ -51,6 +51,7 @@
 
 static int _use_stdinout = 0;
 static socket_handle_t _server_fd = INVALID_SOCKET;
+static const char *_preload_file = NULL;
 
 static socket_handle_t
 socket_init(char *path)
@@ -166,9 +167,9 @@ sharkd_init(int argc, char **argv)
 #endif
 	socket_handle_t fd;
 
-	if (argc != 2)
+	if (argc != 2 && argc != 3)
 	{
-		fprintf(stderr, "Usage: %s <-|socket>\n", argv[0]);
+		fprintf(stderr, "Usage: %s <-|socket> [capture file]\n", argv[0]);
 		fprintf(stderr, "\n");
 
 		fprintf(stderr, "<socket> examples:\n");
@@ -179,9 +180,16 @@ sharkd_init(int argc, char **argv)
 		fprintf(stderr, " - tcp:127.0.0.1:4446 - listen on TCP port 4446\n");
 #endif
 		fprintf(stderr, "\n");
+
+		fprintf(stderr, "[capture file] is loaded once, before accepting connections; sessions\n");
+		fprintf(stderr, "loading the same file share it instead of reading it again.\n");
+		fprintf(stderr, "\n");
 		return -1;
 	}
 
+	if (argc == 3)
+		_preload_file = argv[2];
+
 #ifndef _WIN32
 	signal(SIGCHLD, SIG_IGN);
 #endif
@@ -217,9 +225,28 @@ sharkd_init(int argc, char **argv)
 	return 0;
 }
 
+static void
+preload_cap_file(void)
+{
+	int err = 0;
+
+	if (sharkd_cf_open(_preload_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
+	{
+		fprintf(stderr, "cannot preload %s: %s\n", _preload_file, wtap_strerror(err));
+		return;
+	}
+
+	err = sharkd_load_cap_file();
+	if (err != 0)
+		fprintf(stderr, "cannot preload %s: %s\n", _preload_file, wtap_strerror(err));
+}
+
 int
 sharkd_loop(void)
 {
+	if (_preload_file)
+		preload_cap_file();
+
 	if (_use_stdinout)
 	{
 		return sharkd_session_main();
@@ -244,6 +271,9 @@ sharkd_loop(void)
 		}
 
 		/* wireshark is not ready for handling multiple capture files in single process, so fork(), and handle it in separate process */
+		/* The children share the preloaded capture file, its frames and its
+		   dissection state with us, copy-on-write; on Windows they start
+		   from scratch. */
 #ifndef _WIN32
 		pid = fork();
 		if (pid == 0)
@@ -254,6 +284,9 @@ sharkd_loop(void)
 			dup2(fd, 1);
 			close(fd);
 
+			if (sharkd_cf_reopen() != 0)
+				fprintf(stderr, "cannot reopen %s\n", _preload_file);
+
 			exit(sharkd_session_main());
 		}
 
@@ -546,6 +546,14 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 	if (!tok_file)
 		return;
 
+	/* Loading the same, unchanged, file again; keep what we have. */
+	if (sharkd_cf_is_loaded(tok_file))
+	{
+		fprintf(stderr, "load: reusing the loaded file\n");
+		sharkd_json_simple_reply(0, NULL);
+		return;
+	}
+
 	if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
 	{
 		sharkd_json_simple_reply(err, NULL);
@@ -1212,6 +1220,9 @@ struct sharkd_conv_tap_data
 	conv_hash_t hash;
 	gboolean resolve_name;
 	gboolean resolve_port;
+	const char *sort;
+	guint32 skip;
+	guint32 limit;
 };
 
 static gboolean
@@ -1494,6 +1505,89 @@ sharkd_session_process_tap_rtp_analyse_cb(void *tapdata)
 	json_dumper_end_object(&dumper);
 }
 
+static guint64
+sharkd_session_conv_sort_key(const struct sharkd_conv_tap_data *iu, guint i)
+{
+	guint64 rx_frames, tx_frames, rx_bytes, tx_bytes;
+
+	if (!strncmp(iu->type, "conv:", 5))
+	{
+		const conv_item_t *iui = &g_array_index(iu->hash.conv_array, conv_item_t, i);
+
+		rx_frames = iui->rx_frames;
+		tx_frames = iui->tx_frames;
+		rx_bytes = iui->rx_bytes;
+		tx_bytes = iui->tx_bytes;
+	}
+	else
+	{
+		const hostlist_talker_t *host = &g_array_index(iu->hash.conv_array, hostlist_talker_t, i);
+
+		rx_frames = host->rx_frames;
+		tx_frames = host->tx_frames;
+		rx_bytes = host->rx_bytes;
+		tx_bytes = host->tx_bytes;
+	}
+
+	if (!strcmp(iu->sort, "frames"))
+		return rx_frames + tx_frames;
+	if (!strcmp(iu->sort, "bytes"))
+		return rx_bytes + tx_bytes;
+	if (!strcmp(iu->sort, "rxf"))
+		return rx_frames;
+	if (!strcmp(iu->sort, "rxb"))
+		return rx_bytes;
+	if (!strcmp(iu->sort, "txf"))
+		return tx_frames;
+	if (!strcmp(iu->sort, "txb"))
+		return tx_bytes;
+	return 0;
+}
+
+struct sharkd_conv_sort_item
+{
+	guint64 key;
+	guint idx;
+};
+
+static gint
+sharkd_session_conv_sort_cmp(gconstpointer a, gconstpointer b, gpointer user_data _U_)
+{
+	const struct sharkd_conv_sort_item *item_a = (const struct sharkd_conv_sort_item *) a;
+	const struct sharkd_conv_sort_item *item_b = (const struct sharkd_conv_sort_item *) b;
+
+	/* descending by key, then in table order */
+	if (item_a->key != item_b->key)
+		return (item_a->key < item_b->key) ? 1 : -1;
+	if (item_a->idx != item_b->idx)
+		return (item_a->idx < item_b->idx) ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Returns the order in which to output the conversations or endpoints,
+ * or NULL to output them in table order.
+ */
+static struct sharkd_conv_sort_item *
+sharkd_session_conv_sort(const struct sharkd_conv_tap_data *iu, guint total)
+{
+	struct sharkd_conv_sort_item *items;
+	guint i;
+
+	if (!iu->sort || total == 0)
+		return NULL;
+
+	items = g_new(struct sharkd_conv_sort_item, total);
+	for (i = 0; i < total; i++)
+	{
+		items[i].key = sharkd_session_conv_sort_key(iu, i);
+		items[i].idx = i;
+	}
+
+	g_qsort_with_data(items, total, sizeof(struct sharkd_conv_sort_item), sharkd_session_conv_sort_cmp, NULL);
+	return items;
+}
+
 /**
  * sharkd_session_process_tap_conv_cb()
  *
@@ -1503,6 +1597,7 @@ sharkd_session_process_tap_rtp_analyse_cb(void *tapdata)
  *   (m) proto      - protocol short name
  *   (o) filter     - filter string
  *   (o) geoip      - whether GeoIP information is available, boolean
+ *   (m) total      - number of conversations or hosts, before skip and limit are applied
  *
  *   (o) convs      - array of object with attributes:
  *                  (m) saddr - source address
@@ -1532,7 +1627,9 @@ sharkd_session_process_tap_conv_cb(void *arg)
 	const struct sharkd_conv_tap_data *iu = (struct sharkd_conv_tap_data *) hash->user_data;
 	const char *proto;
 	int proto_with_port;
-	guint i;
+	struct sharkd_conv_sort_item *order;
+	guint total, first, last;
+	guint i, n;
 
 	int with_geoip = 0;
 
@@ -1559,15 +1656,23 @@ sharkd_session_process_tap_conv_cb(void *arg)
 
 	proto_with_port = (!strcmp(proto, "TCP") || !strcmp(proto, "UDP") || !strcmp(proto, "SCTP"));
 
+	total = (iu->hash.conv_array != NULL) ? iu->hash.conv_array->len : 0;
+	first = MIN(iu->skip, total);
+	last = (iu->limit != 0 && iu->limit < total - first) ? first + iu->limit : total;
+	order = sharkd_session_conv_sort(iu, total);
+
 	if (iu->hash.conv_array != NULL && !strncmp(iu->type, "conv:", 5))
 	{
-		for (i = 0; i < iu->hash.conv_array->len; i++)
+		for (n = first; n < last; n++)
 		{
-			conv_item_t *iui = &g_array_index(iu->hash.conv_array, conv_item_t, i);
+			conv_item_t *iui;
 			char *src_addr, *dst_addr;
 			char *src_port, *dst_port;
 			char *filter_str;
 
+			i = order ? order[n].idx : n;
+			iui = &g_array_index(iu->hash.conv_array, conv_item_t, i);
+
 			json_dumper_begin_object(&dumper);
 
 			sharkd_json_value_string("saddr", (src_addr = get_conversation_address(NULL, &iui->src_address, iu->resolve_name)));
@@ -1611,12 +1716,15 @@ sharkd_session_process_tap_conv_cb(void *arg)
 	}
 	else if (iu->hash.conv_array != NULL && !strncmp(iu->type, "endpt:", 6))
 	{
-		for (i = 0; i < iu->hash.conv_array->len; i++)
+		for (n = first; n < last; n++)
 		{
-			hostlist_talker_t *host = &g_array_index(iu->hash.conv_array, hostlist_talker_t, i);
+			hostlist_talker_t *host;
 			char *host_str, *port_str;
 			char *filter_str;
 
+			i = order ? order[n].idx : n;
+			host = &g_array_index(iu->hash.conv_array, hostlist_talker_t, i);
+
 			json_dumper_begin_object(&dumper);
 
 			sharkd_json_value_string("host", (host_str = get_conversation_address(NULL, &host->myaddress, iu->resolve_name)));
@@ -1649,9 +1757,11 @@ sharkd_session_process_tap_conv_cb(void *arg)
 		}
 	}
 	sharkd_json_array_close();
+	g_free(order);
 
 	sharkd_json_value_string("proto", proto);
 	sharkd_json_value_anyf("geoip", with_geoip ? "true" : "false");
+	sharkd_json_value_anyf("total", "%u", total);
 
 	json_dumper_end_object(&dumper);
 }
@@ -2153,6 +2263,9 @@ sharkd_session_process_tap_rtp_cb(void *arg)
  * Input:
  *   (m) tap0         - First tap request
  *   (o) tap1...tap15 - Other tap requests
+ *   (o) sort         - sort conv and endpt taps output, descending, by one of: frames, bytes, rxf, rxb, txf, txb
+ *   (o) skip=N       - skip N entries of conv and endpt taps output
+ *   (o) limit=N      - output only N entries of conv and endpt taps
  *
  * Output object with attributes:
  *   (m) taps  - array of object with attributes:
@@ -2176,14 +2289,39 @@ sharkd_session_process_tap_rtp_cb(void *arg)
 static void
 sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 {
+	const char *tok_sort  = json_find_attr(buf, tokens, count, "sort");
+	const char *tok_skip  = json_find_attr(buf, tokens, count, "skip");
+	const char *tok_limit = json_find_attr(buf, tokens, count, "limit");
+
 	void *taps_data[16];
 	GFreeFunc taps_free[16];
 	int taps_count = 0;
+	guint32 skip = 0, limit = 0;
 	int i;
 
 	rtpstream_tapinfo_t rtp_tapinfo =
 		{ NULL, NULL, NULL, NULL, 0, NULL, 0, TAP_ANALYSE, NULL, NULL, NULL, FALSE };
 
+	if (tok_sort && strcmp(tok_sort, "frames") && strcmp(tok_sort, "bytes") &&
+	    strcmp(tok_sort, "rxf") && strcmp(tok_sort, "rxb") &&
+	    strcmp(tok_sort, "txf") && strcmp(tok_sort, "txb"))
+	{
+		fprintf(stderr, "sharkd_session_process_tap() sort=%s not supported\n", tok_sort);
+		return;
+	}
+
+	if (tok_skip)
+	{
+		if (!ws_strtou32(tok_skip, NULL, &skip))
+			return;
+	}
+
+	if (tok_limit)
+	{
+		if (!ws_strtou32(tok_limit, NULL, &limit))
+			return;
+	}
+
 	for (i = 0; i < 16; i++)
 	{
 		char tapbuf[32];
@@ -2304,6 +2442,10 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			ct_data->resolve_name = TRUE;
 			ct_data->resolve_port = TRUE;
 
+			ct_data->sort = tok_sort;
+			ct_data->skip = skip;
+			ct_data->limit = limit;
+
 			tap_error = register_tap_listener(ct_tapname, &ct_data->hash, tap_filter, 0, NULL, tap_func, sharkd_session_process_tap_conv_cb, NULL);
 
 			tap_data = &ct_data->hash;
@@ -3618,6 +3760,10 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
 
 	ret = prefs_set_pref(pref, &errmsg);
 
+	/* The loaded frames were dissected with the old preferences. */
+	if (ret == PREFS_SET_OK)
+		sharkd_cf_invalidate_loaded();
+
 	sharkd_json_simple_reply(ret, errmsg);
 	g_free(errmsg);
 }
@@ -110,6 +110,11 @@ def cmd_mergecap(program):
     return program('mergecap')
 
 
+@fixtures.fixture(scope='session')
+def cmd_reordercap(program):
+    return program('reordercap')
+
+
 @fixtures.fixture(scope='session')
 def cmd_rawshark(program):
     return program('rawshark')
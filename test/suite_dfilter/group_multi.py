@@ -0,0 +1,82 @@
+# Wireshark tests
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+
+import os.path
+import re
+import subprocess
+import unittest
+import fixtures
+from suite_dfilter.dfiltertest import *
+
+
+# Coloring rules are evaluated together as one multi-filter, sharing the
+# fields they have in common. Several of these look at the same DNS and IP
+# fields. In the DNS capture the TCP and HTTP rules are rejected by the
+# required-field check without being run, and in the HTTP capture the DNS
+# ones are; the negated rule matches precisely because its field is missing.
+multi_filters = (
+    'tcp.port == 80 && tcp.len > 0',
+    'http.request.method == "GET" || tcp.flags.reset == 1',
+    'dns.flags.response == 1 && dns.count.answers > 1',
+    'dns.qry.name contains "google" && ip.ttl < 64',
+    'icmp.type == 8 && ip.len > 60',
+    '!dns && ip.ttl > 32',
+    'dns.flags.response == 0 && ip.src == 10.0.0.0/8',
+    'ip.len > 100 || dns.count.answers == 1',
+    'ip',
+)
+
+
+@fixtures.fixture
+def checkMultiFilter(cmd_tshark, capture_file, conf_path, base_env):
+    def checkMultiFilter_real(self, trace_file, filters):
+        """Color a capture with several rules and check that each packet
+        gets the color of the first rule that matches it on its own."""
+        with open(os.path.join(conf_path, 'colorfilters'), 'w') as f:
+            for i, dfilter in enumerate(filters):
+                f.write('@Rule %d@%s@[%d,0,0][0,0,0]\n' % (i, dfilter, (i + 1) * 256))
+
+        # Which frames does each rule match by itself?
+        expected = {}
+        for i, dfilter in enumerate(filters):
+            output = subprocess.check_output((cmd_tshark,
+                                              '-n',
+                                              '-r', capture_file(trace_file),
+                                              '-Y', dfilter,
+                                              '-T', 'fields',
+                                              '-e', 'frame.number'),
+                                             universal_newlines=True,
+                                             env=base_env)
+            for frame in output.split():
+                expected.setdefault(int(frame), i)
+
+        output = subprocess.check_output((cmd_tshark,
+                                          '-n',
+                                          '-r', capture_file(trace_file),
+                                          '--color',
+                                          '-T', 'psml'),
+                                         universal_newlines=True,
+                                         env=base_env)
+        packets = re.findall(r"<packet(?: foreground='#[0-9a-f]{6}' background='#([0-9a-f]{2})0000')?>", output)
+        self.assertTrue(packets, 'No packets in output:\n%r' % (output,))
+        for frame, background in enumerate(packets, 1):
+            actual = int(background, 16) - 1 if background else None
+            self.assertEqual(expected.get(frame), actual,
+                             'Frame %d: expected rule %r, got rule %r' %
+                             (frame, expected.get(frame), actual))
+    return checkMultiFilter_real
+
+
+@fixtures.uses_fixtures
+class case_multi(unittest.TestCase):
+
+    def test_multi_dns_icmp(self, checkMultiFilter):
+        checkMultiFilter(self, 'dns+icmp.pcapng.gz', multi_filters)
+
+    def test_multi_http(self, checkMultiFilter):
+        checkMultiFilter(self, 'http-ooo.pcap', multi_filters)
+
+    def test_multi_reversed(self, checkMultiFilter):
+        # The catch-all rule first: nothing after it is ever reached.
+        checkMultiFilter(self, 'dns+icmp.pcapng.gz', tuple(reversed(multi_filters)))
@@ -146,3 +146,62 @@ class case_dissect_tcp(subprocesstest.SubprocessTestCase):
             '-Ytls', '-Tfields', '-eframe.number', '-etls.record.length', '-2'))
         output = proc.stdout_str.replace('\r', '')
         self.assertEqual(output, '2\t16\n')
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_dissect_conversation_timeout(subprocesstest.SubprocessTestCase):
+    def make_repeated_capture(self, cmd_editcap, cmd_mergecap, capture_file):
+        '''http-ooo.pcap followed by the same flow an hour later.'''
+        shifted_file = self.filename_from_id('shifted.pcap')
+        repeated_file = self.filename_from_id('repeated.pcap')
+        self.assertRun((cmd_editcap,
+            '-t', '3600',
+            capture_file('http-ooo.pcap'), shifted_file,
+            ))
+        self.assertRun((cmd_mergecap,
+            '-a', '-w', repeated_file,
+            capture_file('http-ooo.pcap'), shifted_file,
+            ))
+        return repeated_file
+
+    def test_conversation_timeout_new_stream(self, cmd_tshark, cmd_editcap, cmd_mergecap, capture_file):
+        '''The idle TCP conversation is freed, so the repeated flow starts a new one.'''
+        repeated_file = self.make_repeated_capture(cmd_editcap, cmd_mergecap, capture_file)
+        proc = self.assertRun((cmd_tshark,
+            '-r', repeated_file,
+            '--disable-protocol', 'http',
+            '-Tfields', '-etcp.stream',
+            ))
+        self.assertEqual(proc.stdout_str.split(), ['0'] * 32)
+        proc = self.assertRun((cmd_tshark,
+            '-r', repeated_file,
+            '--disable-protocol', 'http',
+            '--conversation-timeout', '60',
+            '-Tfields', '-etcp.stream',
+            ))
+        self.assertEqual(proc.stdout_str.split(), ['0'] * 16 + ['1'] * 16)
+
+    def test_conversation_timeout_same_output(self, cmd_tshark, cmd_editcap, cmd_mergecap, capture_file):
+        '''Expiring reassemblies that are done with doesn't change the dissection.'''
+        repeated_file = self.make_repeated_capture(cmd_editcap, cmd_mergecap, capture_file)
+        proc = self.assertRun((cmd_tshark,
+            '-r', repeated_file,
+            '-otcp.reassemble_out_of_order:TRUE',
+            '-Tfields', '-eframe.number', '-etcp.reassembled_in', '-e_ws.col.Info',
+            ))
+        default_output = proc.stdout_str
+        self.assertTrue(self.grepOutput(r'PUT /5 HTTP/1.1'))
+        proc = self.assertRun((cmd_tshark,
+            '-r', repeated_file,
+            '-otcp.reassemble_out_of_order:TRUE',
+            '--conversation-timeout', '60',
+            '-Tfields', '-eframe.number', '-etcp.reassembled_in', '-e_ws.col.Info',
+            ))
+        self.assertEqual(proc.stdout_str, default_output)
+
+    def test_conversation_timeout_twopass(self, cmd_tshark, capture_file):
+        '''--conversation-timeout can't be used with -2.'''
+        self.assertRun((cmd_tshark,
+            '-r', capture_file('http-ooo.pcap'),
+            '--conversation-timeout', '60', '-2',
+            ), expected_return=self.exit_command_line)
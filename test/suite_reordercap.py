@@ -0,0 +1,62 @@
+#
+# -*- coding: utf-8 -*-
+# Wireshark tests
+# By Gerald Combs <gerald@wireshark.org>
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Reordercap tests'''
+
+import random
+import struct
+import subprocesstest
+import fixtures
+
+# Frames are at most this many places away from where they belong.
+max_displacement = 8
+
+def write_out_of_order_pcap(path, frame_count):
+    '''Write a pcap file whose frames are slightly out of timestamp order.'''
+    rng = random.Random(frame_count)
+    with open(path, 'wb') as pcap_file:
+        # Ethernet, microsecond timestamps.
+        pcap_file.write(struct.pack('<IHHiIII', 0xa1b2c3d4, 2, 4, 0, 0, 65535, 1))
+        for frame_num in range(frame_count):
+            # Distinct timestamps, so that every mode has a single right order.
+            usecs = frame_num * 1000 + rng.randrange(max_displacement) * 1000 + frame_num % 1000
+            data = struct.pack('>I', frame_num) * 16
+            pcap_file.write(struct.pack('<IIII', usecs // 1000000, usecs % 1000000, len(data), len(data)))
+            pcap_file.write(data)
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_reordercap(subprocesstest.SubprocessTestCase):
+    def reorder_and_compare(self, cmd_reordercap, frame_count, mode_args):
+        '''Reorder a capture with mode_args and compare it to the default mode's output'''
+        infile = self.filename_from_id('in.pcap')
+        default_file = self.filename_from_id('default.pcap')
+        mode_file = self.filename_from_id('mode.pcap')
+        write_out_of_order_pcap(infile, frame_count)
+        self.assertRun((cmd_reordercap, infile, default_file))
+        self.assertRun([cmd_reordercap] + mode_args + [infile, mode_file])
+        with open(default_file, 'rb') as f:
+            default_data = f.read()
+        with open(mode_file, 'rb') as f:
+            mode_data = f.read()
+        self.assertEqual(len(default_data), 24 + frame_count * (16 + 64))
+        self.assertTrue(default_data == mode_data,
+            'reordercap {} output differs from the default mode'.format(' '.join(mode_args)))
+
+    def test_reordercap_window(self, cmd_reordercap):
+        '''Reorder within a sliding window (-w)'''
+        self.reorder_and_compare(cmd_reordercap, 1000, ['-w', str(max_displacement + 1)])
+
+    def test_reordercap_runs(self, cmd_reordercap):
+        '''Reorder by sorting runs into temporary files and merging them (-m)'''
+        self.reorder_and_compare(cmd_reordercap, 1000, ['-m', '100'])
+
+    def test_reordercap_runs_multi_pass(self, cmd_reordercap):
+        '''Reorder with more runs than are merged at once (-m)'''
+        # 1000 runs of 1 frame, more than reordercap's merge fan-in of 64.
+        self.reorder_and_compare(cmd_reordercap, 1000, ['-m', '1'])
@@ -10,7 +10,11 @@
 '''sharkd tests'''
 
 import json
+import os.path
+import socket
 import subprocess
+import sys
+import time
 import unittest
 import subprocesstest
 import fixtures
@@ -196,6 +200,7 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                         "type": "host",
                         "proto": "TCP",
                         "geoip": MatchAny(bool),
+                        "total": 0,
                         "hosts": [],
                     },
                     {
@@ -203,6 +208,7 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                         "type": "conv",
                         "proto": "Ethernet",
                         "geoip": MatchAny(bool),
+                        "total": 2,
                         "convs": [
                             {
                                 "saddr": MatchAny(str),
@@ -232,6 +238,39 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             },
         ))
 
+    def test_sharkd_req_tap_sort_limit(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "tap", "tap0": "conv:Ethernet", "sort": "bytes", "limit": "1"},
+        ), (
+            {"err": 0},
+            {
+                "err": 0,
+                "taps": [
+                    {
+                        "tap": "conv:Ethernet",
+                        "type": "conv",
+                        "proto": "Ethernet",
+                        "geoip": MatchAny(bool),
+                        "total": 2,
+                        "convs": [
+                            {
+                                "saddr": MatchAny(str),
+                                "daddr": MatchAny(str),
+                                "rxf": 0,
+                                "rxb": 0,
+                                "txf": 2,
+                                "txb": 684,
+                                "start": 0.000295,
+                                "stop": 0.070345,
+                                "filter": "eth.addr==00:08:74:ad:f1:9b && eth.addr==00:0b:82:01:fc:42",
+                            }
+                        ],
+                    },
+                ]
+            },
+        ))
+
     def test_sharkd_req_follow_bad(self, check_sharkd_session, capture_file):
         # Unrecognized taps currently produce no output (not even err).
         check_sharkd_session((
@@ -361,6 +400,51 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             {"err": 0, "comment": "foo\nbar", "fol": MatchAny(list)},
         ))
 
+    def test_sharkd_req_load_same_file(self, check_sharkd_session, capture_file):
+        '''Loading the loaded file again reuses it.'''
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "status"},
+        ), (
+            {"err": 0},
+            {"err": 0},
+            {"frames": 4, "duration": 0.070345000,
+                "filename": "dhcp.pcap", "filesize": 1400},
+        ))
+        self.assertEqual(self.countOutput('load: reusing', count_stdout=False, count_stderr=True), 1)
+
+    def test_sharkd_req_load_same_file_setcomment(self, check_sharkd_session, capture_file):
+        '''Loading the file again discards unsaved comments.'''
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "setcomment", "frame": 3, "comment": "foo\nbar"},
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "frame", "frame": 3},
+        ), (
+            {"err": 0},
+            {"err": 0},
+            {"err": 0},
+            {"err": 0, "fol": MatchAny(list)},
+        ))
+        self.assertEqual(self.countOutput('load: reusing', count_stdout=False, count_stderr=True), 0)
+
+    def test_sharkd_req_load_same_file_setconf(self, check_sharkd_session, capture_file):
+        '''Loading the file again after a preference changed dissects it again.'''
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "setconf", "name": "udp.check_checksum", "value": "TRUE"},
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "status"},
+        ), (
+            {"err": 0},
+            {"err": 0},
+            {"err": 0},
+            {"frames": 4, "duration": 0.070345000,
+                "filename": "dhcp.pcap", "filesize": 1400},
+        ))
+        self.assertEqual(self.countOutput('load: reusing', count_stdout=False, count_stderr=True), 0)
+
     def test_sharkd_req_setconf_bad(self, check_sharkd_session):
         check_sharkd_session((
             {"req": "setconf", "name": "uat:garbage-pref", "value": "\"\""},
@@ -459,4 +543,65 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
         ), (
             {"err": 0},
             MatchAny(),
-        ))
\ No newline at end of file
+        ))
+
+    def test_sharkd_preload(self, cmd_sharkd, capture_file):
+        '''A session loading the preloaded file reuses it.'''
+        sharkd_proc = self.startProcess(
+            (cmd_sharkd, '-', capture_file('dhcp.pcap')), stdin=subprocess.PIPE)
+        sharkd_proc.stdin.write('\n'.join((
+            json.dumps({"req": "load", "file": capture_file('dhcp.pcap')}),
+            json.dumps({"req": "frame", "frame": 2}),
+        )).encode('utf8'))
+        self.waitProcess(sharkd_proc)
+        self.assertEqual([json.loads(line) for line in sharkd_proc.stdout_str.splitlines() if line.strip()], [
+            {"err": 0},
+            {"err": 0, "fol": [["UDP", "udp.stream eq 1"]]},
+        ])
+        self.assertEqual(self.countOutput('load: reusing', count_stdout=False, count_stderr=True), 1)
+
+    @unittest.skipIf(sys.platform.startswith('win32'), 'Sessions share the preloaded file through fork()')
+    def test_sharkd_preload_shared(self, cmd_sharkd, capture_file, home_path):
+        '''Two sessions at once share the preloaded file.'''
+        sock_path = os.path.join(home_path, 'sharkd.sock')
+        sharkd_proc = self.startProcess(
+            (cmd_sharkd, 'unix:' + sock_path, capture_file('dhcp.pcap')))
+
+        sessions = []
+        for attempt in range(100):
+            try:
+                for i in range(2 - len(sessions)):
+                    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+                    sock.connect(sock_path)
+                    sessions.append(sock)
+                break
+            except (FileNotFoundError, ConnectionRefusedError):
+                sock.close()
+                time.sleep(0.1)
+        self.assertEqual(len(sessions), 2, 'Could not connect to sharkd')
+
+        # Both sessions are open before either of them reads the file.
+        for sock in sessions:
+            sock.sendall('\n'.join((
+                json.dumps({"req": "load", "file": capture_file('dhcp.pcap')}),
+                json.dumps({"req": "status"}),
+                json.dumps({"req": "frame", "frame": 2}),
+                json.dumps({"req": "frames"}),
+            )).encode('utf8') + b'\n')
+            sock.shutdown(socket.SHUT_WR)
+
+        for sock in sessions:
+            with sock.makefile('rb') as f:
+                outputs = [json.loads(line) for line in f.read().decode('utf8').splitlines() if line.strip()]
+            sock.close()
+            self.assertEqual(outputs[:3], [
+                {"err": 0},
+                {"frames": 4, "duration": 0.070345000,
+                    "filename": "dhcp.pcap", "filesize": 1400},
+                {"err": 0, "fol": [["UDP", "udp.stream eq 1"]]},
+            ])
+            self.assertEqual([frame["num"] for frame in outputs[3]], [1, 2, 3, 4])
+
+        sharkd_proc.stop_process()
+        self.waitProcess(sharkd_proc)
+        self.assertEqual(self.countOutput('load: reusing', count_stdout=False, count_stderr=True), 2)
@@ -20,10 +20,18 @@ import fixtures
 
 @fixtures.uses_fixtures
 class case_unittests(subprocesstest.SubprocessTestCase):
+    def test_unit_crc32_test(self, program, base_env):
+        '''crc32_test'''
+        self.assertRun(program('crc32_test'), env=base_env)
+
     def test_unit_exntest(self, program, base_env):
         '''exntest'''
         self.assertRun(program('exntest'), env=base_env)
 
+    def test_unit_in_cksum_test(self, program, base_env):
+        '''in_cksum_test'''
+        self.assertRun(program('in_cksum_test'), env=base_env)
+
     def test_unit_oids_test(self, program, base_env):
         '''oids_test'''
         self.assertRun(program('oids_test'), env=base_env)
@@ -32,6 +40,14 @@ class case_unittests(subprocesstest.SubprocessTestCase):
         '''reassemble_test'''
         self.assertRun(program('reassemble_test'), env=base_env)
 
+    def test_unit_stats_tree_test(self, program, base_env):
+        '''stats_tree_test'''
+        self.assertRun(program('stats_tree_test'), env=base_env)
+
+    def test_unit_tcp_unacked_test(self, program, base_env):
+        '''tcp_unacked_test'''
+        self.assertRun(program('tcp_unacked_test'), env=base_env)
+
     def test_unit_tvbtest(self, program, base_env):
         '''tvbtest'''
         self.assertRun(program('tvbtest'), env=base_env)
@@ -59,6 +59,8 @@
 #include "globals.h"
 #include <epan/timestamp.h>
 #include <epan/packet.h>
+#include <epan/conversation.h>
+#include <epan/reassemble.h>
 #ifdef HAVE_LUA
 #include <epan/wslua/init_wslua.h>
 #endif
@@ -142,6 +144,7 @@
 #define LONGOPT_COLOR (65536+1000)
 #define LONGOPT_NO_DUPLICATE_KEYS (65536+1001)
 #define LONGOPT_ELASTIC_MAPPING_FILTER (65536+1002)
+#define LONGOPT_CONVERSATION_TIMEOUT (65536+1003)
 
 #if 0
 #define tshark_debug(...) g_warning(__VA_ARGS__)
@@ -160,6 +163,23 @@ static gboolean perform_two_pass_analysis;
 static guint32 epan_auto_reset_count = 0;
 static gboolean epan_auto_reset = FALSE;
 
+/*
+ * Conversations and reassemblies idle for longer than conv_expire_timeout
+ * seconds are freed during a single-pass run.  conv_expire_samples holds,
+ * at regular points in capture time, a frame number and the latest time
+ * seen before that frame, so that we can tell which frames are older than
+ * the timeout.
+ */
+typedef struct {
+  guint32 frame_num;
+  time_t  secs;
+} conv_expire_sample_t;
+
+static guint32 conv_expire_timeout = 0;
+static GQueue conv_expire_samples = G_QUEUE_INIT;
+static time_t conv_expire_latest;
+static gboolean conv_expire_started = FALSE;
+
 /*
  * The way the packet decode is to be written.
  */
@@ -363,6 +383,9 @@ print_usage(FILE *output)
   fprintf(output, "Processing:\n");
   fprintf(output, "  -2                       perform a two-pass analysis\n");
   fprintf(output, "  -M <packet count>        perform session auto reset\n");
+  fprintf(output, "  --conversation-timeout <seconds>\n");
+  fprintf(output, "                           free conversations idle for more than <seconds>\n");
+  fprintf(output, "                           of capture time (not with -2)\n");
   fprintf(output, "  -R <read filter>         packet Read filter in Wireshark display filter syntax\n");
   fprintf(output, "                           (requires -2)\n");
   fprintf(output, "  -Y <display filter>      packet displaY filter in Wireshark display filter\n");
@@ -684,6 +707,7 @@ main(int argc, char *argv[])
     {"color", no_argument, NULL, LONGOPT_COLOR},
     {"no-duplicate-keys", no_argument, NULL, LONGOPT_NO_DUPLICATE_KEYS},
     {"elastic-mapping-filter", required_argument, NULL, LONGOPT_ELASTIC_MAPPING_FILTER},
+    {"conversation-timeout", required_argument, NULL, LONGOPT_CONVERSATION_TIMEOUT},
     {0, 0, 0, 0 }
   };
   gboolean             arg_error = FALSE;
@@ -1049,6 +1073,10 @@ main(int argc, char *argv[])
         cmdarg_err("-2 does not support auto session reset.");
         arg_error=TRUE;
       }
+      if(conv_expire_timeout){
+        cmdarg_err("-2 does not support conversation timeout.");
+        arg_error=TRUE;
+      }
       perform_two_pass_analysis = TRUE;
       break;
     case 'M':
@@ -1441,6 +1469,13 @@ main(int argc, char *argv[])
       no_duplicate_keys = TRUE;
       node_children_grouper = proto_node_group_children_by_json_key;
       break;
+    case LONGOPT_CONVERSATION_TIMEOUT:
+      if(perform_two_pass_analysis){
+        cmdarg_err("--conversation-timeout does not support two pass analysis.");
+        arg_error=TRUE;
+      }
+      conv_expire_timeout = get_nonzero_guint32(optarg, "conversation timeout");
+      break;
     default:
     case '?':        /* Bad flag - print usage message */
       switch(optopt) {
@@ -3050,6 +3085,130 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
   return passed || fdata->dependent_of_displayed;
 }
 
+/*
+ * Read-ahead for the second pass of two-pass analysis.
+ *
+ * Once the first pass is done the frame table is frozen, so a worker
+ * thread can fetch records with wtap_seek_read() - including any
+ * decompression - while the main thread dissects and prints earlier
+ * frames.  Dissection itself stays on the main thread, as epan isn't
+ * safe to use from more than one thread at a time.
+ *
+ * Slots cycle between two queues: the worker takes empty slots from
+ * free_q, fills them in frame order and pushes them onto ready_q; the
+ * main thread hands them back to free_q when it's done with them.  The
+ * number of slots bounds how far ahead the worker can get.
+ */
+#define READ_AHEAD_SLOTS 64
+
+typedef struct {
+  guint32   framenum;   /* 0 marks the end of the records */
+  wtap_rec  rec;
+  Buffer    buf;
+  int       err;
+  gchar    *err_info;
+} read_ahead_slot_t;
+
+typedef struct {
+  capture_file      *cf;
+  GAsyncQueue       *free_q;
+  GAsyncQueue       *ready_q;
+  GThread           *thread;
+  read_ahead_slot_t  slots[READ_AHEAD_SLOTS];
+} read_ahead_t;
+
+static gpointer
+read_ahead_worker(gpointer data)
+{
+  read_ahead_t      *ra = (read_ahead_t *)data;
+  capture_file      *cf = ra->cf;
+  read_ahead_slot_t *slot;
+  frame_data        *fdata;
+  guint32            framenum;
+
+  for (framenum = 1; framenum <= cf->count; framenum++) {
+    slot = (read_ahead_slot_t *)g_async_queue_pop(ra->free_q);
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+    slot->framenum = framenum;
+    slot->err = 0;
+    slot->err_info = NULL;
+    if (!wtap_seek_read(cf->provider.wth, fdata->file_off, &slot->rec,
+                        &slot->buf, &slot->err, &slot->err_info)) {
+      if (slot->err != 0) {
+        /* Hand the error to the main thread, and stop reading. */
+        g_async_queue_push(ra->ready_q, slot);
+        return NULL;
+      }
+      /* Nothing read, but no error either; skip this frame. */
+      g_async_queue_push(ra->free_q, slot);
+      continue;
+    }
+    g_async_queue_push(ra->ready_q, slot);
+  }
+
+  slot = (read_ahead_slot_t *)g_async_queue_pop(ra->free_q);
+  slot->framenum = 0;
+  slot->err = 0;
+  slot->err_info = NULL;
+  g_async_queue_push(ra->ready_q, slot);
+  return NULL;
+}
+
+static read_ahead_t *
+read_ahead_start(capture_file *cf)
+{
+  read_ahead_t *ra = g_new0(read_ahead_t, 1);
+  int           i;
+
+  ra->cf = cf;
+  ra->free_q = g_async_queue_new();
+  ra->ready_q = g_async_queue_new();
+  for (i = 0; i < READ_AHEAD_SLOTS; i++) {
+    wtap_rec_init(&ra->slots[i].rec);
+    ws_buffer_init(&ra->slots[i].buf, 1500);
+    g_async_queue_push(ra->free_q, &ra->slots[i]);
+  }
+  ra->thread = g_thread_new("tshark_read_ahead", read_ahead_worker, ra);
+  return ra;
+}
+
+/*
+ * Get the next record read by the worker thread.  The slot must be
+ * returned with read_ahead_release() unless it's the last one, i.e.
+ * unless framenum is 0 or err is set.
+ */
+static read_ahead_slot_t *
+read_ahead_next(read_ahead_t *ra)
+{
+  return (read_ahead_slot_t *)g_async_queue_pop(ra->ready_q);
+}
+
+static void
+read_ahead_release(read_ahead_t *ra, read_ahead_slot_t *slot)
+{
+  g_async_queue_push(ra->free_q, slot);
+}
+
+/*
+ * Wait for the worker thread to finish and free everything.  Must only be
+ * called after read_ahead_next() returned the last slot.
+ */
+static void
+read_ahead_finish(read_ahead_t *ra)
+{
+  int i;
+
+  g_thread_join(ra->thread);
+  ra->thread = NULL;
+  for (i = 0; i < READ_AHEAD_SLOTS; i++) {
+    wtap_rec_cleanup(&ra->slots[i].rec);
+    ws_buffer_free(&ra->slots[i].buf);
+  }
+  g_async_queue_unref(ra->free_q);
+  g_async_queue_unref(ra->ready_q);
+  g_free(ra);
+}
+
 static gboolean
 process_cap_file(capture_file *cf, char *save_file, int out_file_type,
     gboolean out_file_name_res, int max_packet_count, gint64 max_byte_count)
@@ -3063,13 +3222,9 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
   gboolean     filtering_tap_listeners;
   guint        tap_flags;
   wtap_dump_params params = WTAP_DUMP_PARAMS_INIT;
-  wtap_rec     rec;
-  Buffer       buf;
   epan_dissect_t *edt = NULL;
   char        *shb_user_appl;
 
-  wtap_rec_init(&rec);
-
   if (save_file != NULL) {
     /* Set up to write to the capture file. */
     wtap_dump_params_init(&params, cf->provider.wth);
@@ -3118,7 +3273,9 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
   tap_flags = union_of_tap_listener_flags();
 
   if (perform_two_pass_analysis) {
-    frame_data *fdata;
+    frame_data        *fdata;
+    read_ahead_t      *ra;
+    read_ahead_slot_t *slot;
 
     tshark_debug("tshark: perform_two_pass_analysis, do_dissection=%s", do_dissection ? "TRUE" : "FALSE");
 
@@ -3195,7 +3352,6 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
 
     cf->provider.prev_dis = NULL;
     cf->provider.prev_cap = NULL;
-    ws_buffer_init(&buf, 1500);
 
     tshark_debug("tshark: done with first pass");
 
@@ -3234,44 +3390,51 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
      */
     set_resolution_synchrony(TRUE);
 
-    for (framenum = 1; err == 0 && framenum <= cf->count; framenum++) {
+    ra = read_ahead_start(cf);
+    for (;;) {
+      slot = read_ahead_next(ra);
+      if (slot->framenum == 0)
+        break;
+      if (slot->err != 0) {
+        err = slot->err;
+        err_info = slot->err_info;
+        break;
+      }
+      framenum = slot->framenum;
       fdata = frame_data_sequence_find(cf->provider.frames, framenum);
-      if (wtap_seek_read(cf->provider.wth, fdata->file_off, &rec, &buf, &err,
-                         &err_info)) {
-        tshark_debug("tshark: invoking process_packet_second_pass() for frame #%d", framenum);
-        if (process_packet_second_pass(cf, edt, fdata, &rec, &buf,
-                                       tap_flags)) {
-          /* Either there's no read filtering or this packet passed the
-             filter, so, if we're writing to a capture file, write
-             this packet out. */
-          if (pdh != NULL) {
-            tshark_debug("tshark: writing packet #%d to outfile", framenum);
-            if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), &err, &err_info)) {
-              /* Error writing to a capture file */
-              tshark_debug("tshark: error writing to a capture file (%d)", err);
-
-              /* Report the error.
-                 XXX - framenum is not necessarily the frame number in
-                 the input file if there was a read filter. */
-              cfile_write_failure_message("TShark", cf->filename, save_file,
-                                          err, err_info, framenum,
-                                          out_file_type);
-              wtap_dump_close(pdh, &err);
-              wtap_dump_params_cleanup(&params);
-              exit(2);
-            }
+      tshark_debug("tshark: invoking process_packet_second_pass() for frame #%d", framenum);
+      if (process_packet_second_pass(cf, edt, fdata, &slot->rec, &slot->buf,
+                                     tap_flags)) {
+        /* Either there's no read filtering or this packet passed the
+           filter, so, if we're writing to a capture file, write
+           this packet out. */
+        if (pdh != NULL) {
+          tshark_debug("tshark: writing packet #%d to outfile", framenum);
+          if (!wtap_dump(pdh, &slot->rec, ws_buffer_start_ptr(&slot->buf), &err, &err_info)) {
+            /* Error writing to a capture file */
+            tshark_debug("tshark: error writing to a capture file (%d)", err);
+
+            /* Report the error.
+               XXX - framenum is not necessarily the frame number in
+               the input file if there was a read filter. */
+            cfile_write_failure_message("TShark", cf->filename, save_file,
+                                        err, err_info, framenum,
+                                        out_file_type);
+            wtap_dump_close(pdh, &err);
+            wtap_dump_params_cleanup(&params);
+            exit(2);
           }
         }
       }
+      read_ahead_release(ra, slot);
     }
+    read_ahead_finish(ra);
 
     if (edt) {
       epan_dissect_free(edt);
       edt = NULL;
     }
 
-    ws_buffer_free(&buf);
-
     tshark_debug("tshark: done with second pass");
   }
   else {
@@ -3366,8 +3529,6 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
     }
   }
 
-  wtap_rec_cleanup(&rec);
-
   if (err != 0 || err_pass1 != 0) {
     tshark_debug("tshark: something failed along the line (%d)", err);
     /*
@@ -3436,6 +3597,53 @@ out:
   return success;
 }
 
+/*
+ * Before dissecting this packet, free the conversations that haven't been
+ * looked up, and the reassemblies that haven't been added to, for more than
+ * conv_expire_timeout seconds of capture time.
+ */
+static void
+expire_idle_conversations(const frame_data *fdata)
+{
+  conv_expire_sample_t *sample, *expire = NULL;
+  time_t step;
+
+  if (!conv_expire_timeout || !fdata->has_ts)
+    return;
+
+  /*
+   * Take a sample every eighth of the timeout: all the frames before this
+   * one are no later than the latest time seen so far.
+   */
+  step = MAX(conv_expire_timeout / 8, 1);
+  if (conv_expire_started) {
+    sample = (conv_expire_sample_t *)g_queue_peek_tail(&conv_expire_samples);
+    if (sample == NULL || fdata->abs_ts.secs - sample->secs >= step) {
+      sample = g_new(conv_expire_sample_t, 1);
+      sample->frame_num = fdata->num;
+      sample->secs = conv_expire_latest;
+      g_queue_push_tail(&conv_expire_samples, sample);
+    }
+  }
+  if (!conv_expire_started || fdata->abs_ts.secs > conv_expire_latest) {
+    conv_expire_latest = fdata->abs_ts.secs;
+    conv_expire_started = TRUE;
+  }
+
+  /* Find the newest sample that's older than the timeout. */
+  while ((sample = (conv_expire_sample_t *)g_queue_peek_head(&conv_expire_samples)) != NULL &&
+         fdata->abs_ts.secs - sample->secs > (time_t)conv_expire_timeout) {
+    g_free(expire);
+    expire = (conv_expire_sample_t *)g_queue_pop_head(&conv_expire_samples);
+  }
+
+  if (expire) {
+    conversation_expire(expire->frame_num);
+    reassembly_tables_expire(expire->frame_num);
+    g_free(expire);
+  }
+}
+
 static gboolean
 process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
                            wtap_rec *rec, const guchar *pd,
@@ -3461,6 +3669,8 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
      over the packets, so, if we'll be printing packet information
      or running taps, we'll be doing it here.) */
   if (edt) {
+    expire_idle_conversations(&fdata);
+
     /* If we're running a filter, prime the epan_dissect_t with that
        filter. */
     if (cf->dfcode)
@@ -4123,6 +4333,11 @@ static void reset_epan_mem(capture_file *cf,epan_dissect_t *edt, gboolean tree,
   epan_dissect_cleanup(edt);
   epan_free(cf->epan);
 
+  /* Frame numbers start over, and the conversations are gone anyway. */
+  while (!g_queue_is_empty(&conv_expire_samples))
+    g_free(g_queue_pop_head(&conv_expire_samples));
+  conv_expire_started = FALSE;
+
   cf->epan = tshark_epan_new(cf);
   epan_dissect_init(edt, cf->epan, tree, visual);
   cf->count = 0;
@@ -0,0 +1,164 @@
+/* tap-heurprofile.c
+ * Heuristic dissector profile for tshark
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/* This module provides the "-z heur,profile" report of how often each
+ * heuristic dissector was tried, how often it accepted the packet and
+ * how much time was spent in it.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <ui/cmdarg_err.h>
+
+void register_tap_listener_heurprofile(void);
+
+typedef struct _heurprofile_t {
+	GPtrArray *entries;
+} heurprofile_t;
+
+
+static tap_packet_status
+heurprofile_packet(void *phs _U_, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *dummy _U_)
+{
+	/* The counters are kept by dissector_try_heuristic() itself. */
+	return TAP_PACKET_DONT_REDRAW;
+}
+
+static void
+heurprofile_add_entry(const gchar *table_name _U_, heur_dtbl_entry_t *hdtbl_entry, gpointer user_data)
+{
+	heurprofile_t *hs = (heurprofile_t *)user_data;
+
+	if (hdtbl_entry->calls != 0)
+		g_ptr_array_add(hs->entries, hdtbl_entry);
+}
+
+static void
+heurprofile_add_table(const char *table_name, struct heur_dissector_list *table _U_, gpointer user_data)
+{
+	heur_dissector_table_foreach(table_name, heurprofile_add_entry, user_data);
+}
+
+/* Most expensive heuristics first; without timing, the most often tried. */
+static gint
+heurprofile_compare(gconstpointer a, gconstpointer b)
+{
+	const heur_dtbl_entry_t *ea = *(const heur_dtbl_entry_t * const *)a;
+	const heur_dtbl_entry_t *eb = *(const heur_dtbl_entry_t * const *)b;
+
+	if (ea->time_us != eb->time_us)
+		return (ea->time_us < eb->time_us) ? 1 : -1;
+	if (ea->calls != eb->calls)
+		return (ea->calls < eb->calls) ? 1 : -1;
+	return strcmp(ea->short_name, eb->short_name);
+}
+
+static void
+heurprofile_draw(void *phs)
+{
+	heurprofile_t *hs = (heurprofile_t *)phs;
+	heur_dtbl_entry_t *hdtbl_entry;
+	guint i;
+
+	g_ptr_array_set_size(hs->entries, 0);
+	dissector_all_heur_tables_foreach_table(heurprofile_add_table, hs, NULL);
+	g_ptr_array_sort(hs->entries, heurprofile_compare);
+
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Heuristic Dissector Profile\n\n");
+	printf("%-20s %-24s %12s %12s %8s %12s %10s\n",
+	    "Table", "Heuristic", "Calls", "Accepts", "Accept%", "Time (ms)", "ns/call");
+	for (i = 0; i < hs->entries->len; i++) {
+		hdtbl_entry = (heur_dtbl_entry_t *)g_ptr_array_index(hs->entries, i);
+		printf("%-20s %-24s %12" G_GINT64_MODIFIER "u %12" G_GINT64_MODIFIER "u %7.2f%% %12.3f %10.1f\n",
+		    hdtbl_entry->list_name, hdtbl_entry->short_name,
+		    hdtbl_entry->calls, hdtbl_entry->accepts,
+		    100.0 * (double)hdtbl_entry->accepts / (double)hdtbl_entry->calls,
+		    (double)hdtbl_entry->time_us / 1000.0,
+		    1000.0 * (double)hdtbl_entry->time_us / (double)hdtbl_entry->calls);
+	}
+	printf("===================================================================\n");
+}
+
+
+static void
+heurprofile_init(const char *opt_arg, void *userdata _U_)
+{
+	heurprofile_t *hs;
+	GString *error_string;
+
+	/*
+	 * The counters cover every packet that was dissected, so there's
+	 * no point in a filter.
+	 */
+	if (strcmp("heur,profile", opt_arg) != 0) {
+		cmdarg_err("invalid \"-z heur,profile\" argument");
+		exit(1);
+	}
+
+	hs = g_new(heurprofile_t, 1);
+	hs->entries = g_ptr_array_new();
+
+	/*
+	 * We only need a listener to get our draw routine called at the
+	 * end of the run.
+	 */
+	error_string = register_tap_listener("frame", hs, NULL, TL_REQUIRES_NOTHING, NULL, heurprofile_packet, heurprofile_draw, NULL);
+	if (error_string) {
+		/* error, we failed to attach to the tap. clean up */
+		g_ptr_array_free(hs->entries, TRUE);
+		g_free(hs);
+
+		cmdarg_err("Couldn't register heur,profile tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+
+	heur_dissector_reset_stats();
+	heur_dissector_set_profiling(TRUE);
+}
+
+static stat_tap_ui heurprofile_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"heur,profile",
+	heurprofile_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_heurprofile(void)
+{
+	register_stat_tap_ui(&heurprofile_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
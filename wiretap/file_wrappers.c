@@ -105,6 +105,10 @@ wtap_get_all_compression_type_extensions_list(void)
 /* #define GZBUFSIZE 8192 */
 #define GZBUFSIZE 4096
 
+/* Buffer size for reading a file sequentially; reading bigger chunks
+   of the file takes fewer reads. */
+#define SEQ_BUFSIZE 65536
+
 /* values for wtap_reader compression */
 typedef enum {
     UNKNOWN,       /* unknown - look for a gzip header */
@@ -126,6 +130,7 @@ struct wtap_reader {
     gint64 raw_pos;             /* current position in file (just to not call lseek()) */
     gint64 pos;                 /* current position in uncompressed data */
     guint size;                 /* buffer size */
+    guint random_size;          /* buffer size to use for random access */
 
     struct wtap_reader_buf in;  /* input buffer, containing compressed data */
     struct wtap_reader_buf out; /* output buffer, containing uncompressed data */
@@ -917,6 +922,12 @@ file_fdopen(int fd)
         /* XXX, verify result? */
     }
 #endif
+    state->random_size = want;
+
+    /* Unless and until we're told this is for random access, assume
+       the file is being read sequentially. */
+    if (want < SEQ_BUFSIZE)
+        want = SEQ_BUFSIZE;
 
     /* allocate buffers */
     state->in.buf = (unsigned char *)g_try_malloc((gsize)want);
@@ -1009,9 +1020,35 @@ file_open(const char *path)
 }
 
 void
-file_set_random_access(FILE_T stream, gboolean random_flag _U_, GPtrArray *seek)
+file_set_random_access(FILE_T stream, gboolean random_flag, GPtrArray *seek)
 {
+    unsigned char *in_buf, *out_buf;
+
     stream->fast_seek = seek;
+
+    /*
+     * Random access mostly reads single records scattered over the file,
+     * so don't read more than a small buffer's worth at a time.  Nothing
+     * has been read into the buffers yet, so just replace them.
+     */
+    if (!random_flag || stream->size <= stream->random_size)
+        return;
+
+    in_buf = (unsigned char *)g_try_malloc((gsize)stream->random_size);
+    out_buf = (unsigned char *)g_try_malloc(((gsize)stream->random_size) << 1);
+    if (in_buf == NULL || out_buf == NULL) {
+        /* Keep the buffers we have. */
+        g_free(out_buf);
+        g_free(in_buf);
+        return;
+    }
+    g_free(stream->in.buf);
+    g_free(stream->out.buf);
+    stream->in.buf = in_buf;
+    stream->out.buf = out_buf;
+    buf_reset(&stream->in);
+    buf_reset(&stream->out);
+    stream->size = stream->random_size;
 }
 
 gint64
@@ -1121,13 +1158,16 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
     /*
      * We're not seeking within the buffer.  Do we have "fast seek" data
      * for the location to which we will be seeking, and is the offset
-     * outside the span for compressed files or is this an uncompressed
-     * file?
+     * outside the span for compressed files, or is the fast seek point
+     * past the current position (so that starting from it means less
+     * to decompress than skipping forward from here), or is this an
+     * uncompressed file?
      *
      * XXX, profile
      */
     if ((here = fast_seek_find(file, file->pos + offset)) &&
-        (offset < 0 || offset > SPAN || here->compression == UNCOMPRESSED)) {
+        (offset < 0 || offset > SPAN || here->out > file->pos ||
+         here->compression == UNCOMPRESSED)) {
         gint64 off, off2;
 
         /*
@@ -1377,6 +1417,31 @@ file_read(void *buf, unsigned int len, FILE_T file)
                we're at the end of the input; just return
                with what we've gotten so far. */
             break;
+        } else if (file->compression == UNCOMPRESSED &&
+                   buf != NULL && len >= file->size) {
+            /* We have nothing in the output buffer, and we
+               want at least a bufferful of uncompressed data;
+               read it straight into the caller's buffer rather
+               than into the output buffer and then copying it.
+               There's nothing before the current position in
+               the output buffer after this. */
+            ssize_t ret;
+
+            buf_reset(&file->out);
+            ret = ws_read(file->fd, buf, len);
+            if (ret < 0) {
+                file->err = errno;
+                file->err_info = NULL;
+                return -1;
+            }
+            if (ret == 0)
+                file->eof = TRUE;
+            n = (guint)ret;
+            buf = (char *)buf + n;
+            file->raw_pos += n;
+            len -= n;
+            got += n;
+            file->pos += n;
         } else {
             /* We have nothing in the output buffer, and
                we can generate more data; get more output,
@@ -1584,6 +1649,12 @@ file_fdreopen(FILE_T file, const char *path)
 
     if ((fd = ws_open(path, O_RDONLY|O_BINARY, 0000)) == -1)
         return FALSE;
+
+    /* Reads that don't seek first carry on from where the old descriptor was. */
+    if (ws_lseek64(fd, file->raw_pos, SEEK_SET) == -1) {
+        ws_close(fd);
+        return FALSE;
+    }
     file->fd = fd;
     return TRUE;
 }
@@ -1615,10 +1686,21 @@ file_close(FILE_T file)
 }
 
 #ifdef HAVE_ZLIB
+/*
+ * We end the gzip stream and start a new one, in the same file, after
+ * every this many bytes of uncompressed data.  Each stream starts with
+ * no history, so a reader can seek to the start of any of them without
+ * having to decompress from an earlier point or to save a window of
+ * uncompressed data; that makes random access to the file we write
+ * cheaper, at the cost of slightly worse compression.
+ */
+#define GZ_MEMBER_SIZE (256 * 1024)
+
 /* internal gzip file state data structure for writing */
 struct wtap_writer {
     int fd;                 /* file descriptor */
     gint64 pos;             /* current position in uncompressed data */
+    gint64 member_start;    /* position at which the current gzip stream started */
     guint size;          /* buffer size, zero if not allocated yet */
     guint want;          /* requested buffer size, default is GZBUFSIZE */
     unsigned char *in;      /* input buffer */
@@ -1669,6 +1751,7 @@ gzwfile_fdopen(int fd)
     /* initialize stream */
     state->err = Z_OK;              /* clear error */
     state->pos = 0;                 /* no uncompressed data yet */
+    state->member_start = 0;
     state->strm.avail_in = 0;       /* no input data yet */
 
     /* return stream */
@@ -1852,6 +1935,14 @@ DIAG_ON(cast-qual)
             return 0;
     }
 
+    /* if the current gzip stream is big enough, finish it; the next
+       write starts another one */
+    if (state->pos - state->member_start >= GZ_MEMBER_SIZE) {
+        if (gz_comp(state, Z_FINISH) == -1)
+            return 0;
+        state->member_start = state->pos;
+    }
+
     /* input was all buffered or compressed (put will fit in int) */
     return (int)put;
 }
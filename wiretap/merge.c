@@ -202,21 +202,99 @@ merge_select_frame_type(int in_file_count, merge_in_file_t in_files[])
 }
 
 /*
- * returns TRUE if first argument is earlier than second
+ * Min-heap of the input files that aren't at EOF, ordered by the record
+ * each one has ready, so that the earliest record can be found without
+ * looking at every file.
+ */
+typedef struct {
+    guint      *files;      /* indices into in_files[] */
+    guint       count;      /* number of files in the heap */
+    gboolean    primed;     /* TRUE once every file has been read from */
+} merge_heap_t;
+
+/*
+ * returns TRUE if the record file a has ready should be written before
+ * the one file b has ready
  */
 static gboolean
-is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
+merge_heap_is_earlier(merge_in_file_t in_files[], guint a, guint b)
 {
-    if (l->secs > r->secs) {  /* left is later */
-        return FALSE;
-    } else if (l->secs < r->secs) { /* left is earlier */
-        return TRUE;
-    } else if (l->nsecs > r->nsecs) { /* tv_sec equal, l.usec later */
-        return FALSE;
-    }
-    /* either one < two or one == two
-     * either way, return one
+    wtap_rec *rec_a = wtap_get_rec(in_files[a].wth);
+    wtap_rec *rec_b = wtap_get_rec(in_files[b].wth);
+    gboolean  has_ts_a = (rec_a->presence_flags & WTAP_HAS_TS) != 0;
+    gboolean  has_ts_b = (rec_b->presence_flags & WTAP_HAS_TS) != 0;
+
+    /*
+     * Records with no time stamp are treated as earlier than all other
+     * records; among those, the first file wins.
      */
+    if (!has_ts_a || !has_ts_b) {
+        if (has_ts_a != has_ts_b)
+            return !has_ts_a;
+        return a < b;
+    }
+    if (rec_a->ts.secs != rec_b->ts.secs)
+        return rec_a->ts.secs < rec_b->ts.secs;
+    if (rec_a->ts.nsecs != rec_b->ts.nsecs)
+        return rec_a->ts.nsecs < rec_b->ts.nsecs;
+    /* Equal time stamps: the later file wins, as it always has. */
+    return a > b;
+}
+
+static void
+merge_heap_sift_up(merge_heap_t *heap, merge_in_file_t in_files[], guint pos)
+{
+    guint file = heap->files[pos];
+    guint parent;
+
+    while (pos > 0) {
+        parent = (pos - 1) / 2;
+        if (!merge_heap_is_earlier(in_files, file, heap->files[parent]))
+            break;
+        heap->files[pos] = heap->files[parent];
+        pos = parent;
+    }
+    heap->files[pos] = file;
+}
+
+static void
+merge_heap_sift_down(merge_heap_t *heap, merge_in_file_t in_files[], guint pos)
+{
+    guint file = heap->files[pos];
+    guint child;
+
+    for (;;) {
+        child = 2 * pos + 1;
+        if (child >= heap->count)
+            break;
+        if (child + 1 < heap->count &&
+            merge_heap_is_earlier(in_files, heap->files[child + 1], heap->files[child]))
+            child++;
+        if (!merge_heap_is_earlier(in_files, heap->files[child], file))
+            break;
+        heap->files[pos] = heap->files[child];
+        pos = child;
+    }
+    heap->files[pos] = file;
+}
+
+/*
+ * Read the next record from a file, updating its state; returns FALSE
+ * on a read error.
+ */
+static gboolean
+merge_read_next(merge_in_file_t *in_file, int *err, gchar **err_info)
+{
+    gint64 data_offset;
+
+    if (!wtap_read(in_file->wth, err, err_info, &data_offset)) {
+        if (*err != 0) {
+            in_file->state = GOT_ERROR;
+            return FALSE;
+        }
+        in_file->state = AT_EOF;
+    } else
+        in_file->state = RECORD_PRESENT;
     return TRUE;
 }
 
@@ -232,6 +310,7 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * On an EOF (meaning all the files are at EOF), set *err to 0 and return
  * NULL.
  *
+ * @param heap heap of the files that aren't at EOF
  * @param in_file_count number of entries in in_files
  * @param in_files input file array
  * @param err wiretap error, if failed
@@ -241,66 +320,53 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * all files
  */
 static merge_in_file_t *
-merge_read_packet(int in_file_count, merge_in_file_t in_files[],
+merge_read_packet(merge_heap_t *heap, int in_file_count, merge_in_file_t in_files[],
                   int *err, gchar **err_info)
 {
     int i;
-    int ei = -1;
-    nstime_t tv = NSTIME_INIT_MAX;
-    wtap_rec *rec;
+    guint ei;
 
     /*
      * Make sure we have a record available from each file that's not at
-     * EOF, and search for the record with the earliest time stamp or
-     * with no time stamp (those records are treated as earlier than
-     * all other records).  Yes, this means you won't get a chronological
-     * merge of those records, but you obviously *can't* get that.
+     * EOF, and pick the record with the earliest time stamp or with no
+     * time stamp (those records are treated as earlier than all other
+     * records).  Yes, this means you won't get a chronological merge of
+     * those records, but you obviously *can't* get that.
+     *
+     * Only the file we returned the last record from needs a new record;
+     * if the inputs don't overlap in time, that file usually stays at the
+     * top of the heap, and putting it back costs two comparisons.
      */
-    for (i = 0; i < in_file_count; i++) {
-        gint64 data_offset;
-
-        if (in_files[i].state == RECORD_NOT_PRESENT) {
-            /*
-             * No packet available, and we haven't seen an error or EOF yet,
-             * so try to read the next packet.
-             */
-            if (!wtap_read(in_files[i].wth, err, err_info, &data_offset)) {
-                if (*err != 0) {
-                    in_files[i].state = GOT_ERROR;
-                    return &in_files[i];
-                }
-                in_files[i].state = AT_EOF;
-            } else
-                in_files[i].state = RECORD_PRESENT;
-        }
-
-        if (in_files[i].state == RECORD_PRESENT) {
-            rec = wtap_get_rec(in_files[i].wth);
-            if (!(rec->presence_flags & WTAP_HAS_TS)) {
-                /*
-                 * No time stamp.  Pick this record, and stop looking.
-                 */
-                ei = i;
-                break;
-            }
-            if (is_earlier(&rec->ts, &tv)) {
-                /*
-                 * This record's time stamp is earlier than any of the
-                 * records we've seen so far.  Pick it, for now, but
-                 * keep looking.
-                 */
-                tv = rec->ts;
-                ei = i;
+    if (!heap->primed) {
+        for (i = 0; i < in_file_count; i++) {
+            if (!merge_read_next(&in_files[i], err, err_info))
+                return &in_files[i];
+            if (in_files[i].state == RECORD_PRESENT) {
+                heap->files[heap->count] = i;
+                merge_heap_sift_up(heap, in_files, heap->count++);
             }
         }
+        heap->primed = TRUE;
+    } else if (heap->count > 0) {
+        ei = heap->files[0];
+        if (in_files[ei].state == RECORD_NOT_PRESENT) {
+            if (!merge_read_next(&in_files[ei], err, err_info))
+                return &in_files[ei];
+            if (in_files[ei].state == AT_EOF)
+                heap->files[0] = heap->files[--heap->count];
+            if (heap->count > 0)
+                merge_heap_sift_down(heap, in_files, 0);
+        }
     }
 
-    if (ei == -1) {
+    if (heap->count == 0) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
     }
 
+    ei = heap->files[0];
+
     /* We'll need to read another packet from this file. */
     in_files[ei].state = RECORD_NOT_PRESENT;
 
@@ -842,6 +908,11 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
     int                 count = 0;
     gboolean            stop_flag = FALSE;
     wtap_rec *rec,      snap_rec;
+    merge_heap_t        heap;
+
+    heap.files = g_new(guint, in_file_count);
+    heap.count = 0;
+    heap.primed = FALSE;
 
     for (;;) {
         *err = 0;
@@ -851,7 +922,7 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
                                                err_info);
         }
         else {
-            in_file = merge_read_packet(in_file_count, in_files, err,
+            in_file = merge_read_packet(&heap, in_file_count, in_files, err,
                                         err_info);
         }
 
@@ -932,6 +1003,8 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
         }
     }
 
+    g_free(heap.files);
+
     if (cb)
         cb->callback_func(MERGE_EVENT_DONE, count, in_files, in_file_count, cb->data);
 
@@ -16,7 +16,9 @@
 #include "config.h"
 
 #include <glib.h>
+#include "ws_attributes.h"
 #include <wsutil/crc32.h>
+#include "crc32_int.h"
 
 #define CRC32_ACCUMULATE(c,d,table) (c=(c>>8)^(table)[(c^(d))&0xFF])
 
@@ -39,7 +41,6 @@
 /* in the FTP archive "ftp.adelaide.edu.au/pub/rocksoft".        */
 /*                                                               */
 /*****************************************************************/
-#define CRC32C(c,d) CRC32_ACCUMULATE(c,d,crc32c_table)
 
 static const guint32 crc32c_table[256] = {
 		0x00000000U, 0xF26B8303U, 0xE13B70F7U, 0x1350F3F4U, 0xC79A971FU,
@@ -353,6 +354,110 @@ static const guint32 crc32_5D6DCB[] =
 		0x0098206c, 0x00c54da7, 0x0022fbfa, 0x007f9631
 };
 
+/*
+ * "Slicing-by-8" tables, built from crc32c_table and crc32_ccitt_table
+ * on first use: entry [k][i] is the CRC register contents after feeding
+ * byte i followed by k zero bytes, so that eight bytes can be folded in
+ * with eight independent lookups instead of eight dependent ones.
+ */
+static guint32 crc32c_slice_table[8][256];
+static guint32 crc32_ccitt_slice_table[8][256];
+
+/* Which CPU-specific routines we can use. */
+#ifdef HAVE_SSE4_2
+static gboolean crc32c_use_sse42 = FALSE;
+#endif
+#if defined(HAVE_SSE4_2) && defined(HAVE_PCLMUL)
+static gboolean crc32_use_pclmul = FALSE;
+#endif
+
+static void
+crc32_build_slice_table(guint32 slice_table[8][256], const guint32 *table)
+{
+	guint i, k;
+
+	for (i = 0; i < 256; i++)
+		slice_table[0][i] = table[i];
+	for (k = 1; k < 8; k++) {
+		for (i = 0; i < 256; i++)
+			slice_table[k][i] = (slice_table[k - 1][i] >> 8) ^
+			    table[slice_table[k - 1][i] & 0xFF];
+	}
+}
+
+static void
+crc32_init(void)
+{
+	static gsize initialized = 0;
+
+	if (g_once_init_enter(&initialized)) {
+		crc32_build_slice_table(crc32c_slice_table, crc32c_table);
+		crc32_build_slice_table(crc32_ccitt_slice_table, crc32_ccitt_table);
+#ifdef HAVE_SSE4_2
+		crc32c_use_sse42 = crc32c_sse42_usable();
+#ifdef HAVE_PCLMUL
+		crc32_use_pclmul = crc32c_use_sse42 && crc32_pclmul_usable();
+#endif
+#endif
+		g_once_init_leave(&initialized, 1);
+	}
+}
+
+void
+crc32_force_portable(gboolean portable _U_)
+{
+	crc32_init();
+#ifdef HAVE_SSE4_2
+	crc32c_use_sse42 = !portable && crc32c_sse42_usable();
+#ifdef HAVE_PCLMUL
+	crc32_use_pclmul = crc32c_use_sse42 && crc32_pclmul_usable();
+#endif
+#endif
+}
+
+/*
+ * Accumulate a bit-reflected CRC-32 eight bytes at a time.  The bytes
+ * are combined explicitly, so this works regardless of byte order.
+ */
+static guint32
+crc32_slice8_accumulate(guint32 slice_table[8][256], guint32 crc,
+    const guint8 *buf, size_t len)
+{
+	guint32 lo, hi;
+
+	while (len >= 8) {
+		lo = crc ^ ((guint32)buf[0] | (guint32)buf[1] << 8 |
+		    (guint32)buf[2] << 16 | (guint32)buf[3] << 24);
+		hi = (guint32)buf[4] | (guint32)buf[5] << 8 |
+		    (guint32)buf[6] << 16 | (guint32)buf[7] << 24;
+		crc = slice_table[7][lo & 0xFF] ^
+		    slice_table[6][(lo >> 8) & 0xFF] ^
+		    slice_table[5][(lo >> 16) & 0xFF] ^
+		    slice_table[4][lo >> 24] ^
+		    slice_table[3][hi & 0xFF] ^
+		    slice_table[2][(hi >> 8) & 0xFF] ^
+		    slice_table[1][(hi >> 16) & 0xFF] ^
+		    slice_table[0][hi >> 24];
+		buf += 8;
+		len -= 8;
+	}
+	while (len-- > 0)
+		CRC32_ACCUMULATE(crc, *buf++, slice_table[0]);
+
+	return crc;
+}
+
+static guint32
+crc32c_accumulate(guint32 crc, const guint8 *buf, size_t len)
+{
+	crc32_init();
+#ifdef HAVE_SSE4_2
+	if (crc32c_use_sse42)
+		return crc32c_sse42_accumulate(crc, buf, len);
+#endif
+	return crc32_slice8_accumulate(crc32c_slice_table, crc, buf, len);
+}
+
 guint32
 crc32c_table_lookup (guchar pos)
 {
@@ -368,21 +473,17 @@ crc32_ccitt_table_lookup (guchar pos)
 guint32
 crc32c_calculate(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
 	crc = CRC32C_SWAP(crc);
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
+	if (len > 0)
+		crc = crc32c_accumulate(crc, (const guint8 *)buf, len);
 	return CRC32C_SWAP(crc);
 }
 
 guint32
 crc32c_calculate_no_swap(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
+	if (len > 0)
+		crc = crc32c_accumulate(crc, (const guint8 *)buf, len);
 
 	return crc;
 }
@@ -396,11 +497,19 @@ crc32_ccitt(const guint8 *buf, guint len)
 guint32
 crc32_ccitt_seed(const guint8 *buf, guint len, guint32 seed)
 {
-	guint i;
 	guint32 crc32 = seed;
 
-	for (i = 0; i < len; i++)
-		CRC32_ACCUMULATE(crc32, buf[i], crc32_ccitt_table);
+	crc32_init();
+#if defined(HAVE_SSE4_2) && defined(HAVE_PCLMUL)
+	if (crc32_use_pclmul && len >= 64) {
+		guint folded = len & ~15U;
+
+		crc32 = crc32_pclmul_accumulate(crc32, buf, folded);
+		buf += folded;
+		len -= folded;
+	}
+#endif
+	crc32 = crc32_slice8_accumulate(crc32_ccitt_slice_table, crc32, buf, len);
 
 	return ( ~crc32 );
 }
@@ -0,0 +1,41 @@
+/* crc32_int.h
+ * Declarations of the CPU-specific CRC-32 routines used by crc32.c
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CRC32_INT_H__
+#define __CRC32_INT_H__
+
+#include "ws_symbol_export.h"
+
+/* If portable is TRUE, use the portable routines from now on even if the
+ * CPU has faster instructions; for tests of both. */
+WS_DLL_PUBLIC void crc32_force_portable(gboolean portable);
+
+#ifdef HAVE_SSE4_2
+/* TRUE if the CPU has the SSE4.2 crc32 instruction. */
+gboolean crc32c_sse42_usable(void);
+
+/* Accumulate a CRC32C, without pre- or post-conditioning, with the crc32
+ * instruction. */
+guint32 crc32c_sse42_accumulate(guint32 crc, const guint8 *buf, size_t len);
+
+#ifdef HAVE_PCLMUL
+/* TRUE if the CPU has the PCLMULQDQ instruction. */
+gboolean crc32_pclmul_usable(void);
+#endif
+#endif
+
+#ifdef HAVE_PCLMUL
+/* Accumulate a CRC-32 (reflected polynomial 0xEDB88320), without pre- or
+ * post-conditioning, by folding with carry-less multiplication.  len must
+ * be a multiple of 16 and at least 64. */
+guint32 crc32_pclmul_accumulate(guint32 crc, const guint8 *buf, size_t len);
+#endif
+
+#endif /* __CRC32_INT_H__ */
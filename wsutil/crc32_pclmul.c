@@ -0,0 +1,132 @@
+/* crc32_pclmul.c
+ * CRC-32 by folding with the PCLMULQDQ instruction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This is the algorithm from Intel's "Fast CRC Computation for Generic
+ * Polynomials Using PCLMULQDQ Instruction" white paper, for the
+ * bit-reflected CRC-32 polynomial, with the folding and Barrett reduction
+ * constants given at the end of the paper.
+ */
+
+#include "config.h"
+
+#ifdef HAVE_PCLMUL
+
+#include <glib.h>
+
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#include "crc32_int.h"
+
+#define cast_128aligned__m128i(p) ((const __m128i *) (const void *) (p))
+
+/* x^(4*128+32) mod P and x^(4*128-32) mod P, to fold 512 bits at a time. */
+static const guint64 crc32_k1k2[2] = { G_GUINT64_CONSTANT(0x0154442bd4), G_GUINT64_CONSTANT(0x01c6e41596) };
+/* x^(128+32) mod P and x^(128-32) mod P, to fold 128 bits at a time. */
+static const guint64 crc32_k3k4[2] = { G_GUINT64_CONSTANT(0x01751997d0), G_GUINT64_CONSTANT(0x00ccaa009e) };
+/* x^64 mod P, to fold 96 bits to 64. */
+static const guint64 crc32_k5k0[2] = { G_GUINT64_CONSTANT(0x0163cd6124), G_GUINT64_CONSTANT(0x0000000000) };
+/* P(x) and floor(x^64 / P(x)), for the Barrett reduction. */
+static const guint64 crc32_poly[2] = { G_GUINT64_CONSTANT(0x01db710641), G_GUINT64_CONSTANT(0x01f7011641) };
+
+guint32
+crc32_pclmul_accumulate(guint32 crc, const guint8 *buf, size_t len)
+{
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+	/* Load the first 64 bytes, and fold in the CRC so far. */
+	x1 = _mm_loadu_si128(cast_128aligned__m128i(buf + 0x00));
+	x2 = _mm_loadu_si128(cast_128aligned__m128i(buf + 0x10));
+	x3 = _mm_loadu_si128(cast_128aligned__m128i(buf + 0x20));
+	x4 = _mm_loadu_si128(cast_128aligned__m128i(buf + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+	x0 = _mm_loadu_si128(cast_128aligned__m128i(crc32_k1k2));
+	buf += 64;
+	len -= 64;
+
+	/* Fold 64 bytes at a time, in four independent lanes. */
+	while (len >= 64) {
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+		y5 = _mm_loadu_si128(cast_128aligned__m128i(buf + 0x00));
+		y6 = _mm_loadu_si128(cast_128aligned__m128i(buf + 0x10));
+		y7 = _mm_loadu_si128(cast_128aligned__m128i(buf + 0x20));
+		y8 = _mm_loadu_si128(cast_128aligned__m128i(buf + 0x30));
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+		buf += 64;
+		len -= 64;
+	}
+
+	/* Fold the four lanes into one. */
+	x0 = _mm_loadu_si128(cast_128aligned__m128i(crc32_k3k4));
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	/* Fold any remaining 16-byte blocks. */
+	while (len >= 16) {
+		x2 = _mm_loadu_si128(cast_128aligned__m128i(buf));
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+		buf += 16;
+		len -= 16;
+	}
+
+	/* Fold 128 bits to 64. */
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x1 = _mm_srli_si128(x1, 8);
+	x1 = _mm_xor_si128(x1, x2);
+	x0 = _mm_loadl_epi64(cast_128aligned__m128i(crc32_k5k0));
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, x3);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	/* Barrett reduction to 32 bits. */
+	x0 = _mm_loadu_si128(cast_128aligned__m128i(crc32_poly));
+	x2 = _mm_and_si128(x1, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+	x2 = _mm_and_si128(x2, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	/* The CRC is in the second 32-bit word. */
+	return (guint32)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+#endif /* HAVE_PCLMUL */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
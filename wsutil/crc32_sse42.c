@@ -0,0 +1,89 @@
+/* crc32_sse42.c
+ * CRC32C with the SSE4.2 crc32 instruction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_SSE4_2
+
+#include <glib.h>
+#include "ws_cpuid.h"
+
+#ifdef _WIN32
+  #include <tmmintrin.h>
+#endif
+
+#include <nmmintrin.h>
+#include <string.h>
+#include "crc32_int.h"
+
+gboolean
+crc32c_sse42_usable(void)
+{
+	return ws_cpuid_sse42() != 0;
+}
+
+#ifdef HAVE_PCLMUL
+gboolean
+crc32_pclmul_usable(void)
+{
+	guint32 CPUInfo[4];
+
+	if (!ws_cpuid(CPUInfo, 1))
+		return FALSE;
+
+	/* in ECX bit 1 toggled on */
+	return (CPUInfo[2] & (1 << 1)) != 0;
+}
+#endif
+
+guint32
+crc32c_sse42_accumulate(guint32 crc, const guint8 *buf, size_t len)
+{
+#if defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64)
+	guint64 crc64 = crc;
+	guint64 word;
+
+	while (len >= 8) {
+		memcpy(&word, buf, 8);
+		crc64 = _mm_crc32_u64(crc64, word);
+		buf += 8;
+		len -= 8;
+	}
+	crc = (guint32)crc64;
+#else
+	guint32 word;
+
+	while (len >= 4) {
+		memcpy(&word, buf, 4);
+		crc = _mm_crc32_u32(crc, word);
+		buf += 4;
+		len -= 4;
+	}
+#endif
+	while (len-- > 0)
+		crc = _mm_crc32_u8(crc, *buf++);
+
+	return crc;
+}
+
+#endif /* HAVE_SSE4_2 */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
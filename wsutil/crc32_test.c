@@ -0,0 +1,171 @@
+/* crc32_test.c
+ * Standalone program to test, and time, the CRC-32 routines.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <wsutil/crc32.h>
+#include "crc32_int.h"
+
+static gboolean failed = FALSE;
+
+/* Bit-at-a-time reference for a bit-reflected CRC-32 register. */
+static guint32
+reference_crc32(guint32 poly, guint32 crc, const guint8 *buf, guint len)
+{
+	guint i;
+	int bit;
+
+	for (i = 0; i < len; i++) {
+		crc ^= buf[i];
+		for (bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+	}
+	return crc;
+}
+
+#define CRC32_CCITT_POLY	0xEDB88320
+#define CRC32C_POLY		0x82F63B78
+
+static void
+check_vectors(const char *path)
+{
+	const guint8 *check = (const guint8 *)"123456789";
+	guint32 crc;
+
+	crc = crc32_ccitt(check, 9);
+	if (crc != 0xCBF43926) {
+		printf("Failed: %s CRC-32 of \"123456789\" is 0x%08x, expected 0xcbf43926\n", path, crc);
+		failed = TRUE;
+	}
+
+	crc = ~crc32c_calculate_no_swap(check, 9, CRC32C_PRELOAD);
+	if (crc != 0xE3069283) {
+		printf("Failed: %s CRC32C of \"123456789\" is 0x%08x, expected 0xe3069283\n", path, crc);
+		failed = TRUE;
+	}
+}
+
+/* Compare with the reference at every alignment, for lengths on both sides
+ * of the block sizes the optimized routines work in. */
+static void
+check_lengths(const char *path, const guint8 *data)
+{
+	guint offset, len;
+	guint32 crc, expected;
+
+	for (offset = 0; offset < 16; offset++) {
+		for (len = 0; len < 300; len++) {
+			expected = ~reference_crc32(CRC32_CCITT_POLY, CRC32_CCITT_SEED, data + offset, len);
+			crc = crc32_ccitt(data + offset, len);
+			if (crc != expected) {
+				printf("Failed: %s CRC-32 offset %u length %u is 0x%08x, expected 0x%08x\n",
+				    path, offset, len, crc, expected);
+				failed = TRUE;
+			}
+
+			expected = reference_crc32(CRC32C_POLY, 0x12345678, data + offset, len);
+			crc = crc32c_calculate_no_swap(data + offset, len, 0x12345678);
+			if (crc != expected) {
+				printf("Failed: %s CRC32C offset %u length %u is 0x%08x, expected 0x%08x\n",
+				    path, offset, len, crc, expected);
+				failed = TRUE;
+			}
+		}
+	}
+}
+
+/* Report the throughput for typical frame sizes; this doesn't check it. */
+static void
+time_lengths(const guint8 *data)
+{
+	static const guint lengths[] = { 64, 512, 1500, 9000 };
+	guint i, iter, iterations;
+	guint32 sum = 0;
+	gint64 start_time, ccitt_us, crc32c_us;
+
+	for (i = 0; i < G_N_ELEMENTS(lengths); i++) {
+		/* About 64MB of data per routine. */
+		iterations = (64 * 1024 * 1024) / lengths[i];
+
+		start_time = g_get_monotonic_time();
+		for (iter = 0; iter < iterations; iter++)
+			sum += crc32_ccitt(data, lengths[i]);
+		ccitt_us = g_get_monotonic_time() - start_time;
+
+		start_time = g_get_monotonic_time();
+		for (iter = 0; iter < iterations; iter++)
+			sum += crc32c_calculate(data, lengths[i], CRC32C_PRELOAD);
+		crc32c_us = g_get_monotonic_time() - start_time;
+
+		printf("%5u bytes: CRC-32 %8.1f MB/s, CRC32C %8.1f MB/s\n", lengths[i],
+		    ccitt_us ? (double)iterations * lengths[i] / ccitt_us : 0.0,
+		    crc32c_us ? (double)iterations * lengths[i] / crc32c_us : 0.0);
+	}
+	/* Keep the compiler from optimizing the loops away. */
+	if (sum == 0x5eed)
+		printf("\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	gboolean time_it = FALSE;
+	guint8 *data;
+	guint i;
+
+	if (argc == 2 && strcmp(argv[1], "--time") == 0) {
+		time_it = TRUE;
+	} else if (argc != 1) {
+		fprintf(stderr, "Usage: %s [--time]\n", argv[0]);
+		exit(1);
+	}
+
+	data = (guint8 *)g_malloc(9000 + 16);
+	for (i = 0; i < 9000 + 16; i++)
+		data[i] = (guint8)(i * 131 + (i >> 8));
+
+	/* Whatever this CPU can use, then the portable routines. */
+	check_vectors("optimized");
+	check_lengths("optimized", data);
+	crc32_force_portable(TRUE);
+	check_vectors("portable");
+	check_lengths("portable", data);
+	if (!failed)
+		printf("Passed CRC-32 tests\n");
+
+	if (time_it) {
+		printf("Portable:\n");
+		time_lengths(data);
+		crc32_force_portable(FALSE);
+		printf("Optimized:\n");
+		time_lengths(data);
+	}
+
+	g_free(data);
+	exit(failed ? 1 : 0);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
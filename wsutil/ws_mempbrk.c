@@ -22,20 +22,34 @@
 #endif
 #endif
 
+#include <string.h>
+
 #include <glib.h>
 #include "ws_symbol_export.h"
 #include "ws_mempbrk.h"
 #include "ws_mempbrk_int.h"
+#include "bits_ctz.h"
 
 void
 ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const gchar *needles)
 {
     const gchar *n = needles;
+    size_t length = strlen(needles);
+    size_t i;
+
     while (*n) {
         pattern->patt[(int)*n] = 1;
         n++;
     }
 
+    if (length > 0 && length <= WS_MEMPBRK_MAX_FEW_NEEDLES) {
+        pattern->num_few_needles = (guint8)length;
+        for (i = 0; i < WS_MEMPBRK_MAX_FEW_NEEDLES; i++)
+            pattern->few_needles[i] = (guint8)needles[i < length ? i : 0];
+    } else {
+        pattern->num_few_needles = 0;
+    }
+
 #ifdef HAVE_SSE4_2
     ws_mempbrk_sse42_compile(pattern, needles);
 #endif
@@ -60,9 +74,57 @@ ws_mempbrk_portable_exec(const guint8* haystack, size_t haystacklen, const ws_me
 }
 
 
+#ifdef WS_HAVE_SSE2
+/*
+ * Compare each 16-byte block of the haystack against every needle and
+ * OR the results together.  For the handful of needles that line and
+ * token scanning uses, this is cheaper than the SSE4.2 string
+ * instructions, and it doesn't need them to be available.
+ *
+ * The haystack must be at least 16 bytes long; the last block is
+ * loaded so that it ends at the end of the haystack, overlapping the
+ * previous one, so no byte past the end is ever read.
+ */
+const guint8 *
+ws_mempbrk_sse2_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+    const guint8 *p = haystack;
+    const guint8 *last = haystack + haystacklen - 16;
+    const __m128i n0 = _mm_set1_epi8((char)pattern->few_needles[0]);
+    const __m128i n1 = _mm_set1_epi8((char)pattern->few_needles[1]);
+    const __m128i n2 = _mm_set1_epi8((char)pattern->few_needles[2]);
+    const __m128i n3 = _mm_set1_epi8((char)pattern->few_needles[3]);
+    __m128i block, match;
+    unsigned int mask;
+
+    for (;;) {
+        if (p > last)
+            p = last;
+        block = _mm_loadu_si128((const __m128i *)(const void *)p);
+        match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, n0), _mm_cmpeq_epi8(block, n1)),
+                             _mm_or_si128(_mm_cmpeq_epi8(block, n2), _mm_cmpeq_epi8(block, n3)));
+        mask = (unsigned int)_mm_movemask_epi8(match);
+        if (mask) {
+            p += ws_ctz(mask);
+            if (found_needle)
+                *found_needle = *p;
+            return p;
+        }
+        if (p == last)
+            return NULL;
+        p += 16;
+    }
+}
+#endif
+
 WS_DLL_PUBLIC const guint8 *
 ws_mempbrk_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
 {
+#ifdef WS_HAVE_SSE2
+    if (haystacklen >= 16 && pattern->num_few_needles)
+        return ws_mempbrk_sse2_exec(haystack, haystacklen, pattern, found_needle);
+#endif
+
 #ifdef HAVE_SSE4_2
     if (haystacklen >= 16 && pattern->use_sse42)
         return ws_mempbrk_sse42_exec(haystack, haystacklen, pattern, found_needle);
@@ -16,10 +16,20 @@
 #include <emmintrin.h>
 #endif
 
+/** Maximum number of needles ws_mempbrk_exec() compares one by one against
+ * each block of the haystack when SSE2 is available.
+ */
+#define WS_MEMPBRK_MAX_FEW_NEEDLES 4
+
 /** The pattern object used for ws_mempbrk_exec().
  */
 typedef struct {
     gchar patt[256];
+    /* If there are at most WS_MEMPBRK_MAX_FEW_NEEDLES needles, the number of
+     * needles and the needles themselves, with the unused slots filled with
+     * copies of the first needle; otherwise num_few_needles is 0. */
+    guint8 num_few_needles;
+    guint8 few_needles[WS_MEMPBRK_MAX_FEW_NEEDLES];
 #ifdef HAVE_SSE4_2
     gboolean use_sse42;
     __m128i mask;
@@ -10,8 +10,14 @@
 #ifndef __WS_MEMPBRK_INT_H__
 #define __WS_MEMPBRK_INT_H__
 
+#include "ws_sse2.h"
+
 const guint8 *ws_mempbrk_portable_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle);
 
+#ifdef WS_HAVE_SSE2
+const guint8 *ws_mempbrk_sse2_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle);
+#endif
+
 #ifdef HAVE_SSE4_2
 void ws_mempbrk_sse42_compile(ws_mempbrk_pattern* pattern, const gchar *needles);
 const char *ws_mempbrk_sse42_exec(const char* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle);
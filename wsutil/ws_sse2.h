@@ -0,0 +1,26 @@
+/* ws_sse2.h
+ * Whether the compiler targets SSE2
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_SSE2_H__
+#define __WS_SSE2_H__
+
+/*
+ * SSE2 is part of the baseline on x86-64, and enabled on 32-bit x86 when
+ * the compiler targets it, so code using it needs no runtime check; unlike
+ * SSE4.2 (see ws_cpuid.h) it's decided at compile time.  WS_HAVE_SSE2 is
+ * defined, and the SSE2 intrinsics are declared, when that's the case.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WS_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#endif /* __WS_SSE2_H__ */